@@ -48,6 +48,9 @@ typedef struct {
 static void slew_timer_callback(indigo_device *device) {
 	double diffRA = MOUNT_RAW_COORDINATES_RA_ITEM->number.target - MOUNT_RAW_COORDINATES_RA_ITEM->number.value;
 	double diffDec = MOUNT_RAW_COORDINATES_DEC_ITEM->number.target - MOUNT_RAW_COORDINATES_DEC_ITEM->number.value;
+	// clients enumerating properties meanwhile never see RA of one step with Dec of another, sections are finished by updates
+	indigo_begin_property_write(MOUNT_RAW_COORDINATES_PROPERTY);
+	indigo_begin_property_write(MOUNT_EQUATORIAL_COORDINATES_PROPERTY);
 	if (diffRA == 0 && diffDec == 0) {
 		MOUNT_EQUATORIAL_COORDINATES_PROPERTY->state = MOUNT_RAW_COORDINATES_PROPERTY->state = INDIGO_OK_STATE;
 		PRIVATE_DATA->slew_timer = NULL;
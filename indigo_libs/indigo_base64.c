@@ -21,14 +21,25 @@
 
 #include <ctype.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
 #include "indigo_base64.h"
 #include "indigo_base64_luts.h"
 #include <stdio.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BASE64_X86
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define BASE64_NEON
+#include <arm_neon.h>
+#endif
 
 /* out size should be at least 4*inlen/3 + 4.
  * returns length of out (without trailing NULL).
  */
-long base64_encode(unsigned char *out, const unsigned char *in, long inlen) {
+static long base64_encode_scalar(unsigned char *out, const unsigned char *in, long inlen) {
 	uint16_t* b64lut = (uint16_t*)base64lut;
 	long dlen = ((inlen+2)/3)*4; /* 4/3, rounded up */
 	uint16_t* wbuf = (uint16_t*)out;
@@ -59,7 +70,7 @@ long base64_encode(unsigned char *out, const unsigned char *in, long inlen) {
 
 
 /* base64 should not contain whitespaces.*/
-long base64_decode_fast(unsigned char* out, const unsigned char* in, long inlen) {
+static long base64_decode_fast_scalar(unsigned char* out, const unsigned char* in, long inlen) {
 	long outlen = 0;
 	uint8_t b1, b2, b3;
 	uint16_t s1, s2;
@@ -181,4 +192,309 @@ long base64_decode_fast_nl(unsigned char* out, const unsigned char* in, long inl
 	return outlen;
 }
 
+/* SIMD implementations process whole blocks and leave the rest (incl. padding and any invalid
+ * input) to the scalar code, so the result is always identical to the scalar implementation.
+ */
+
+#ifdef BASE64_X86
+
+__attribute__((target("ssse3")))
+static inline __m128i encode_reshuffle_ssse3(__m128i in) {
+	in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+	__m128i t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+	__m128i t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+	return _mm_or_si128(t0, t1);
+}
+
+__attribute__((target("ssse3")))
+static inline __m128i encode_translate_ssse3(__m128i in) {
+	const __m128i lut = _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+	__m128i indices = _mm_subs_epu8(in, _mm_set1_epi8(51));
+	indices = _mm_sub_epi8(indices, _mm_cmpgt_epi8(in, _mm_set1_epi8(25)));
+	return _mm_add_epi8(in, _mm_shuffle_epi8(lut, indices));
+}
+
+__attribute__((target("ssse3")))
+static long base64_encode_ssse3(unsigned char *out, const unsigned char *in, long inlen) {
+	long dlen = ((inlen + 2) / 3) * 4;
+	/* 12 bytes are encoded, but 16 bytes are read */
+	while (inlen >= 16) {
+		__m128i data = _mm_loadu_si128((const __m128i *)in);
+		_mm_storeu_si128((__m128i *)out, encode_translate_ssse3(encode_reshuffle_ssse3(data)));
+		in += 12;
+		out += 16;
+		inlen -= 12;
+	}
+	base64_encode_scalar(out, in, inlen);
+	return dlen;
+}
+
+__attribute__((target("ssse3")))
+static inline bool decode_translate_ssse3(__m128i *data) {
+	const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+	const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i mask_2f = _mm_set1_epi8(0x2F);
+	__m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(*data, 4), mask_2f);
+	__m128i lo_nibbles = _mm_and_si128(*data, mask_2f);
+	__m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+	__m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+	if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())))
+		return false;
+	__m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(*data, mask_2f), hi_nibbles));
+	__m128i sextets = _mm_add_epi8(*data, roll);
+	__m128i merged = _mm_madd_epi16(_mm_maddubs_epi16(sextets, _mm_set1_epi32(0x01400140)), _mm_set1_epi32(0x00011000));
+	*data = _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+	return true;
+}
+
+__attribute__((target("ssse3")))
+static long base64_decode_fast_ssse3(unsigned char *out, const unsigned char *in, long inlen) {
+	long outlen = 0;
+	/* 16 bytes are stored, but only 12 are valid, keep at least 2 quads for scalar code */
+	while (inlen >= 16 + 8) {
+		__m128i data = _mm_loadu_si128((const __m128i *)in);
+		if (!decode_translate_ssse3(&data))
+			break;
+		_mm_storeu_si128((__m128i *)out, data);
+		in += 16;
+		out += 12;
+		outlen += 12;
+		inlen -= 16;
+	}
+	return outlen + base64_decode_fast_scalar(out, in, inlen);
+}
+
+__attribute__((target("avx2")))
+static long base64_encode_avx2(unsigned char *out, const unsigned char *in, long inlen) {
+	long dlen = ((inlen + 2) / 3) * 4;
+	const __m256i shuffle = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1, 10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+	const __m256i lut = _mm256_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0, 65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+	/* 2 x 12 bytes are encoded, but 28 bytes are read */
+	while (inlen >= 28) {
+		__m256i data = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)in)), _mm_loadu_si128((const __m128i *)(in + 12)), 1);
+		data = _mm256_shuffle_epi8(data, shuffle);
+		__m256i t0 = _mm256_mulhi_epu16(_mm256_and_si256(data, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040));
+		__m256i t1 = _mm256_mullo_epi16(_mm256_and_si256(data, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010));
+		data = _mm256_or_si256(t0, t1);
+		__m256i indices = _mm256_subs_epu8(data, _mm256_set1_epi8(51));
+		indices = _mm256_sub_epi8(indices, _mm256_cmpgt_epi8(data, _mm256_set1_epi8(25)));
+		_mm256_storeu_si256((__m256i *)out, _mm256_add_epi8(data, _mm256_shuffle_epi8(lut, indices)));
+		in += 24;
+		out += 32;
+		inlen -= 24;
+	}
+	base64_encode_ssse3(out, in, inlen);
+	return dlen;
+}
+
+__attribute__((target("avx2")))
+static long base64_decode_fast_avx2(unsigned char *out, const unsigned char *in, long inlen) {
+	const __m256i lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A, 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+	const __m256i lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0, 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m256i mask_2f = _mm256_set1_epi8(0x2F);
+	const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	long outlen = 0;
+	/* 32 bytes are stored, but only 24 are valid, keep at least 4 quads for scalar code */
+	while (inlen >= 32 + 16) {
+		__m256i data = _mm256_loadu_si256((const __m256i *)in);
+		__m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(data, 4), mask_2f);
+		__m256i lo_nibbles = _mm256_and_si256(data, mask_2f);
+		__m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+		__m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+		if (!_mm256_testz_si256(lo, hi))
+			break;
+		__m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(_mm256_cmpeq_epi8(data, mask_2f), hi_nibbles));
+		data = _mm256_add_epi8(data, roll);
+		data = _mm256_madd_epi16(_mm256_maddubs_epi16(data, _mm256_set1_epi32(0x01400140)), _mm256_set1_epi32(0x00011000));
+		data = _mm256_shuffle_epi8(data, pack);
+		data = _mm256_permutevar8x32_epi32(data, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+		_mm256_storeu_si256((__m256i *)out, data);
+		in += 32;
+		out += 24;
+		outlen += 24;
+		inlen -= 32;
+	}
+	return outlen + base64_decode_fast_ssse3(out, in, inlen);
+}
+
+#endif
+
+#ifdef BASE64_NEON
+
+static long base64_encode_neon(unsigned char *out, const unsigned char *in, long inlen) {
+	long dlen = ((inlen + 2) / 3) * 4;
+	uint8x16x4_t lut;
+	for (int i = 0; i < 4; i++)
+		lut.val[i] = vld1q_u8((const uint8_t *)base64digits + 16 * i);
+	while (inlen >= 48) {
+		uint8x16x3_t data = vld3q_u8(in);
+		uint8x16x4_t result;
+		result.val[0] = vshrq_n_u8(data.val[0], 2);
+		result.val[1] = vandq_u8(vorrq_u8(vshrq_n_u8(data.val[1], 4), vshlq_n_u8(data.val[0], 4)), vdupq_n_u8(0x3F));
+		result.val[2] = vandq_u8(vorrq_u8(vshrq_n_u8(data.val[2], 6), vshlq_n_u8(data.val[1], 2)), vdupq_n_u8(0x3F));
+		result.val[3] = vandq_u8(data.val[2], vdupq_n_u8(0x3F));
+		for (int i = 0; i < 4; i++)
+			result.val[i] = vqtbl4q_u8(lut, result.val[i]);
+		vst4q_u8(out, result);
+		in += 48;
+		out += 64;
+		inlen -= 48;
+	}
+	base64_encode_scalar(out, in, inlen);
+	return dlen;
+}
+
+static const uint8_t base64_decode_lut[128] = {
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x3E, 0xFF, 0xFF, 0xFF, 0x3F,
+	0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+	0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+	0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+static long base64_decode_fast_neon(unsigned char *out, const unsigned char *in, long inlen) {
+	uint8x16x4_t lut_lo, lut_hi;
+	for (int i = 0; i < 4; i++) {
+		lut_lo.val[i] = vld1q_u8(base64_decode_lut + 16 * i);
+		lut_hi.val[i] = vld1q_u8(base64_decode_lut + 64 + 16 * i);
+	}
+	long outlen = 0;
+	/* keep at least last quad for scalar code */
+	while (inlen >= 64 + 4) {
+		uint8x16x4_t data = vld4q_u8(in);
+		uint8x16_t error = vdupq_n_u8(0);
+		for (int i = 0; i < 4; i++) {
+			uint8x16_t sextets = vqtbx4q_u8(vqtbl4q_u8(lut_lo, data.val[i]), lut_hi, vsubq_u8(data.val[i], vdupq_n_u8(64)));
+			error = vorrq_u8(error, vorrq_u8(sextets, data.val[i]));
+			data.val[i] = sextets;
+		}
+		if (vmaxvq_u8(error) & 0x80)
+			break;
+		uint8x16x3_t result;
+		result.val[0] = vorrq_u8(vshlq_n_u8(data.val[0], 2), vshrq_n_u8(data.val[1], 4));
+		result.val[1] = vorrq_u8(vshlq_n_u8(data.val[1], 4), vshrq_n_u8(data.val[2], 2));
+		result.val[2] = vorrq_u8(vshlq_n_u8(data.val[2], 6), data.val[3]);
+		vst3q_u8(out, result);
+		in += 64;
+		out += 48;
+		outlen += 48;
+		inlen -= 64;
+	}
+	return outlen + base64_decode_fast_scalar(out, in, inlen);
+}
+
+#endif
+
+typedef long (*base64_function)(unsigned char *out, const unsigned char *in, long inlen);
+
+static base64_function encode_function = base64_encode_scalar;
+static base64_function decode_function = base64_decode_fast_scalar;
+static pthread_once_t select_once = PTHREAD_ONCE_INIT;
+
+static void select_functions(void) {
+#if defined(BASE64_X86)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		encode_function = base64_encode_avx2;
+		decode_function = base64_decode_fast_avx2;
+	} else if (__builtin_cpu_supports("ssse3")) {
+		encode_function = base64_encode_ssse3;
+		decode_function = base64_decode_fast_ssse3;
+	}
+#elif defined(BASE64_NEON)
+	encode_function = base64_encode_neon;
+	decode_function = base64_decode_fast_neon;
+#endif
+}
+
+long base64_encode(unsigned char *out, const unsigned char *in, long inlen) {
+	pthread_once(&select_once, select_functions);
+	return encode_function(out, in, inlen);
+}
+
+long base64_decode_fast(unsigned char *out, const unsigned char *in, long inlen) {
+	pthread_once(&select_once, select_functions);
+	return decode_function(out, in, inlen);
+}
+
+#define NL_LINE_RAW 54			/* 54 raw = 72 encoded */
+#define NL_LINE_ENCODED 72
+#define NL_BLOCK_LINES 64
+
+long base64_encode_nl(unsigned char *out, const unsigned char *in, long inlen) {
+	pthread_once(&select_once, select_functions);
+	unsigned char block[NL_BLOCK_LINES * NL_LINE_ENCODED + 4];
+	unsigned char *pnt = out;
+	while (inlen > 0) {
+		/* encode many lines at once and split them while copying */
+		long len = (NL_BLOCK_LINES * NL_LINE_RAW < inlen) ? NL_BLOCK_LINES * NL_LINE_RAW : inlen;
+		long enclen = encode_function(block, in, len);
+		for (long i = 0; i < enclen; i += NL_LINE_ENCODED) {
+			long line = (NL_LINE_ENCODED < enclen - i) ? NL_LINE_ENCODED : enclen - i;
+			memcpy(pnt, block + i, line);
+			pnt += line;
+			*pnt++ = '\n';
+		}
+		inlen -= len;
+		in += len;
+	}
+	*pnt = 0; // NULL terminate
+	return pnt - out;
+}
+
+#define WS_CHUNK_SIZE 4096
 
+long base64_decode_fast_ws(unsigned char *out, const unsigned char *in, long inlen, long *incomplete) {
+	unsigned char chunk[WS_CHUNK_SIZE];
+	long outlen = 0;
+	long used = 0;
+	const unsigned char *end = in + inlen;
+	while (in < end) {
+		if (end - in >= 8 && used <= WS_CHUNK_SIZE - 8) {
+			/* copy 8 characters at once if none of them is whitespace or control character */
+			uint64_t word;
+			memcpy(&word, in, 8);
+			if (((word - 0x2121212121212121ULL) & ~word & 0x8080808080808080ULL) == 0) {
+				memcpy(chunk + used, &word, 8);
+				used += 8;
+				in += 8;
+			} else {
+				/* whitespace and control characters are dropped without branching */
+				for (int i = 0; i < 8; i++) {
+					unsigned char c = *in++;
+					chunk[used] = c;
+					used += c > ' ';
+				}
+			}
+		} else {
+			unsigned char c = *in++;
+			chunk[used] = c;
+			used += c > ' ';
+		}
+		if (used == WS_CHUNK_SIZE) {
+			long len = base64_decode_fast(out, chunk, used);
+			out += len;
+			outlen += len;
+			used = 0;
+		}
+	}
+	long rest = used % 4;
+	if (incomplete != NULL) {
+		long skipped = 0;
+		const unsigned char *pnt = end;
+		while (skipped < rest) {
+			if (*--pnt > ' ')
+				skipped++;
+		}
+		*incomplete = end - pnt;
+		used -= rest;
+	}
+	if (used >= 4)
+		outlen += base64_decode_fast(out, chunk, used);
+	return outlen;
+}
@@ -27,9 +27,17 @@ extern "C" {
 #endif
 
 extern long base64_encode(unsigned char *out, const unsigned char *in, long inlen);
+/* line is terminated by '\n' after each 72 characters and at the end, out size should be at least 4*inlen/3 + inlen/54 + 5.
+ */
+extern long base64_encode_nl(unsigned char *out, const unsigned char *in, long inlen);
 extern long base64_decode_fast(unsigned char *out, const unsigned char *in, long inlen);
 extern long base64_decode_fast_nl(unsigned char *out, const unsigned char *in, long inlen);
 
+/* whitespace (incl. line breaks) is ignored, if incomplete is not NULL, trailing characters not forming
+ * complete quartet are not decoded and their count (incl. whitespace) is returned there.
+ */
+extern long base64_decode_fast_ws(unsigned char *out, const unsigned char *in, long inlen, long *incomplete);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,233 @@
+// Copyright (c) 2016 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 Build 0 - PoC by Peter Polakovic <peter.polakovic@cloudmakers.eu>
+
+/** INDIGO binary wire protocol parser
+ \file indigo_bin.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <errno.h>
+
+#include "indigo_bin.h"
+#include "indigo_io.h"
+
+//#undef INDIGO_TRACE_PROTOCOL
+//#define INDIGO_TRACE_PROTOCOL(c) c
+
+#define PROPERTY_SIZE sizeof(indigo_property)+INDIGO_MAX_ITEMS*(sizeof(indigo_item))
+
+#define BIN_BUFFER_SIZE	(64 * 1024)
+
+/* Buffered input, many messages are consumed per read() */
+
+typedef struct {
+	int handle;
+	long start, end;                    /* unprocessed input */
+	int name_count;                     /* number of interned names */
+	char (*names)[INDIGO_NAME_SIZE];    /* names interned by client */
+	uint8_t data[BIN_BUFFER_SIZE];
+} input_reader;
+
+static bool fill(input_reader *reader, long needed) {
+	if (reader->end - reader->start >= needed)
+		return true;
+	if (reader->start + needed > BIN_BUFFER_SIZE) {
+		memmove(reader->data, reader->data + reader->start, reader->end - reader->start);
+		reader->end -= reader->start;
+		reader->start = 0;
+	}
+	while (reader->end - reader->start < needed) {
+		ssize_t bytes_read = read(reader->handle, reader->data + reader->end, BIN_BUFFER_SIZE - reader->end);
+		if (bytes_read < 0 && errno == EINTR)
+			continue;
+		if (bytes_read <= 0)
+			return false;
+		reader->end += bytes_read;
+	}
+	return true;
+}
+
+static bool read_byte(input_reader *reader, uint8_t *value) {
+	if (!fill(reader, 1))
+		return false;
+	*value = reader->data[reader->start++];
+	return true;
+}
+
+static bool read_varint(input_reader *reader, uint64_t *value) {
+	*value = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		uint8_t byte;
+		if (!read_byte(reader, &byte))
+			return false;
+		*value |= (uint64_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+/* strings which don't fit to target buffer are rejected as protocol error */
+
+static bool read_string(input_reader *reader, char *string, long size) {
+	uint64_t length;
+	if (!read_varint(reader, &length) || length >= (uint64_t)size || !fill(reader, length))
+		return false;
+	memcpy(string, reader->data + reader->start, length);
+	string[length] = 0;
+	reader->start += length;
+	return true;
+}
+
+static bool read_name(input_reader *reader, char *name) {
+	uint64_t reference;
+	if (!read_varint(reader, &reference))
+		return false;
+	if (reference > 0) {
+		if (reference > (uint64_t)reader->name_count)
+			return false;
+		strcpy(name, reader->names[reference - 1]);
+		return true;
+	}
+	if (!read_string(reader, name, INDIGO_NAME_SIZE))
+		return false;
+	if (reader->name_count < INDIGO_BIN_MAX_NAMES)
+		strcpy(reader->names[reader->name_count++], name);
+	return true;
+}
+
+static bool read_double(input_reader *reader, double *value) {
+	if (!fill(reader, 8))
+		return false;
+	uint64_t bits;
+	memcpy(&bits, reader->data + reader->start, 8);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	bits = __builtin_bswap64(bits);
+#endif
+	memcpy(value, &bits, 8);
+	reader->start += 8;
+	return true;
+}
+
+static bool read_new_vector(input_reader *reader, indigo_property *property) {
+	uint8_t type;
+	uint64_t count;
+	if (!read_byte(reader, &type) || !read_name(reader, property->device) || !read_name(reader, property->name) || !read_varint(reader, &count) || count > INDIGO_MAX_ITEMS)
+		return false;
+	property->type = type;
+	property->count = (int)count;
+	for (int i = 0; i < property->count; i++) {
+		indigo_item *item = property->items + i;
+		if (!read_name(reader, item->name))
+			return false;
+		switch (property->type) {
+			case INDIGO_TEXT_VECTOR:
+				if (!read_string(reader, item->text.value, INDIGO_VALUE_SIZE))
+					return false;
+				break;
+			case INDIGO_NUMBER_VECTOR:
+				if (!read_double(reader, &item->number.value))
+					return false;
+				break;
+			case INDIGO_SWITCH_VECTOR: {
+				uint8_t value;
+				if (!read_byte(reader, &value))
+					return false;
+				item->sw.value = value != 0;
+				break;
+			}
+			default:
+				return false;
+		}
+	}
+	return true;
+}
+
+void indigo_bin_parse(indigo_device *device, indigo_client *client) {
+	indigo_adapter_context *context = (indigo_adapter_context*)client->client_context;
+	input_reader *reader = malloc(sizeof(input_reader));
+	assert(reader != NULL);
+	memset(reader, 0, offsetof(input_reader, data));
+	reader->handle = context->input;
+	reader->names = malloc(INDIGO_BIN_MAX_NAMES * INDIGO_NAME_SIZE);
+	assert(reader->names != NULL);
+	char property_buffer[PROPERTY_SIZE];
+	indigo_property *property = (indigo_property *)property_buffer;
+	memset(property_buffer, 0, PROPERTY_SIZE);
+	static const uint8_t preamble[] = { INDIGO_BIN_MAGIC, 'I', 'B', INDIGO_BIN_PROTOCOL_VERSION };
+	if (!fill(reader, sizeof(preamble)) || memcmp(reader->data, preamble, sizeof(preamble))) {
+		indigo_error("BIN Parser: invalid preamble");
+		goto exit_loop;
+	}
+	reader->start += sizeof(preamble);
+	/* adapter is silent until preamble is echoed, so no broadcast can get ahead of it */
+	pthread_mutex_lock(&context->output_mutex);
+	indigo_buffer_write(context->output_buffer, (const char *)preamble, sizeof(preamble));
+	indigo_buffer_flush(context->output_buffer);
+	client->version = INDIGO_VERSION_CURRENT;
+	pthread_mutex_unlock(&context->output_mutex);
+	while (true) {
+		uint8_t type;
+		if (!read_byte(reader, &type))
+			goto exit_loop;
+		/* only items touched by the last message are cleared */
+		memset(property, 0, sizeof(indigo_property) + (property->count < INDIGO_MAX_ITEMS ? property->count + 1 : INDIGO_MAX_ITEMS) * sizeof(indigo_item));
+		switch (type) {
+			case INDIGO_BIN_GET_PROPERTIES:
+				if (!read_name(reader, property->device) || !read_name(reader, property->name))
+					goto protocol_error;
+				INDIGO_TRACE_PROTOCOL(indigo_trace("BIN Parser: getProperties '%s' '%s'", property->device, property->name));
+				indigo_enumerate_properties(client, property);
+				break;
+			case INDIGO_BIN_ENABLE_BLOB: {
+				uint8_t mode;
+				if (!read_byte(reader, &mode) || mode > INDIGO_ENABLE_BLOB_URL)
+					goto protocol_error;
+				client->enable_blob = mode;
+				INDIGO_DEBUG(indigo_debug("BLOB mode is %d", mode));
+				break;
+			}
+			case INDIGO_BIN_NEW_VECTOR:
+				if (!read_new_vector(reader, property))
+					goto protocol_error;
+				property->version = client->version;
+				INDIGO_TRACE_PROTOCOL(indigo_trace("BIN Parser: newVector '%s' '%s'", property->device, property->name));
+				indigo_change_property(client, property);
+				break;
+			default:
+				goto protocol_error;
+		}
+	}
+protocol_error:
+	indigo_error("BIN Parser: protocol error");
+exit_loop:
+	free(reader->names);
+	free(reader);
+	close(context->input);
+	indigo_log("BIN Parser: parser finished");
+}
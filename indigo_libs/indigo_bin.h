@@ -0,0 +1,84 @@
+// Copyright (c) 2016 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 Build 0 - PoC by Peter Polakovic <peter.polakovic@cloudmakers.eu>
+
+/** INDIGO binary wire protocol
+ \file indigo_bin.h
+
+ Session is opened by client with preamble { INDIGO_BIN_MAGIC, 'I', 'B', INDIGO_BIN_PROTOCOL_VERSION }, server echoes it back.
+ Each message starts with indigo_bin_message_type byte followed by its fields encoded as:
+
+ - byte: single byte (enum values, booleans, flags)
+ - varint: unsigned LEB128 (counts, lengths, sizes)
+ - string: varint length and UTF-8 bytes without terminating zero
+ - name: varint reference, 0 is followed by string (added to name table if shorter than INDIGO_NAME_SIZE and table is not full), N > 0 refers to N-th name in the table
+ - double: 8 bytes IEEE 754, little endian
+ - raw: bytes of BLOB or array elements (little endian)
+
+ Each direction of session has its own name table.
+ */
+
+#ifndef indigo_bin_h
+#define indigo_bin_h
+
+#include <stdio.h>
+#include "indigo_bus.h"
+
+/** First byte of session preamble (never used by XML, JSON or HTTP).
+ */
+#define INDIGO_BIN_MAGIC						0xC1
+
+/** Protocol version sent in session preamble.
+ */
+#define INDIGO_BIN_PROTOCOL_VERSION	1
+
+/** Maximal number of interned names in each direction of session.
+ */
+#define INDIGO_BIN_MAX_NAMES				4096
+
+/** Flags of definition, update and delete messages.
+ */
+#define INDIGO_BIN_FLAG_DELTA				0x01
+#define INDIGO_BIN_FLAG_MESSAGE			0x02
+
+/** BLOB item value kinds.
+ */
+#define INDIGO_BIN_BLOB_NONE				0
+#define INDIGO_BIN_BLOB_RAW					1
+#define INDIGO_BIN_BLOB_URL					2
+
+/** Message types.
+ */
+typedef enum {
+	INDIGO_BIN_GET_PROPERTIES = 0x01,		///< client: name device, name property (empty for all)
+	INDIGO_BIN_ENABLE_BLOB = 0x02,			///< client: byte indigo_enable_blob
+	INDIGO_BIN_NEW_VECTOR = 0x03,				///< client: byte type, name device, name property, varint count, items (name, text: string, number: double, switch: byte)
+	INDIGO_BIN_DEF_VECTOR = 0x10,				///< server: byte type, name device, name property, name group, string label, byte perm, byte state, byte rule, byte flags, [string message], varint count, items (name, string label, text: string value, number: name format, double min, max, step, target, value, switch: byte, light: byte, array: byte type)
+	INDIGO_BIN_SET_VECTOR = 0x11,				///< server: byte type, name device, name property, byte state, byte flags, [string message], varint count, items (name, text: string, number: double target, value, switch: byte, light: byte, BLOB: byte kind, [name format, varint size, raw | name format, string url], array: byte type, varint rank, varint shape[rank], varint count, raw)
+	INDIGO_BIN_DELETE_PROPERTY = 0x12,	///< server: name device, name property (empty for all), byte flags, [string message]
+	INDIGO_BIN_DELETE_ITEMS = 0x13,			///< server: name device, name property, byte flags, [string message], varint count, names
+	INDIGO_BIN_MESSAGE = 0x14						///< server: name device, string message (empty if there is no message)
+} indigo_bin_message_type;
+
+/** Binary wire protocol parser.
+ */
+extern void indigo_bin_parse(indigo_device *device, indigo_client *client);
+
+#endif /* indigo_bin_h */
@@ -27,6 +27,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <time.h>
 #include <assert.h>
 #include <pthread.h>
@@ -34,6 +35,7 @@
 #include <syslog.h>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sched.h>
 
 #include "indigo_bus.h"
 #include "indigo_names.h"
@@ -58,7 +60,8 @@ char *indigo_property_type_text[] = {
 	"NUMBER",
 	"SWITCH",
 	"LIGHT",
-	"BLOB"
+	"BLOB",
+	"ARRAY"
 };
 
 char *indigo_property_state_text[] = {
@@ -82,6 +85,13 @@ char *indigo_switch_rule_text[] = {
 	"AnyOfMany"
 };
 
+char *indigo_array_type_text[] = {
+	"UNDEFINED",
+	"double",
+	"float",
+	"int32"
+};
+
 indigo_property INDIGO_ALL_PROPERTIES;
 
 bool indigo_log_level = false;
@@ -234,6 +244,12 @@ void indigo_debug_property(const char *message, indigo_property *property, bool
 					else
 						indigo_debug("  '%s' (%ld bytes, '%s', '%s')",item->name, item->blob.size, item->blob.format, item->blob.url);
 					break;
+				case INDIGO_ARRAY_VECTOR:
+					if (defs)
+						indigo_debug("  '%s' %s // %s", item->name, indigo_array_type_text[item->array.type], item->label);
+					else
+						indigo_debug("  '%s' (%ld x %s)",item->name, item->array.count, indigo_array_type_text[item->array.type]);
+					break;
 				}
 			}
 		}
@@ -241,6 +257,212 @@ void indigo_debug_property(const char *message, indigo_property *property, bool
 	}
 }
 
+typedef struct {
+	bool busy;
+	long size;
+	indigo_property *property;
+} property_pool;
+
+static pthread_key_t change_request_key;
+static pthread_key_t snapshot_key;
+static pthread_key_t delta_key;
+static pthread_once_t property_pool_once = PTHREAD_ONCE_INIT;
+
+static void release_property_pool(void *data) {
+	property_pool *pool = data;
+	free(pool->property);
+	free(pool);
+}
+
+static void create_property_pool_keys() {
+	pthread_key_create(&change_request_key, release_property_pool);
+	pthread_key_create(&snapshot_key, release_property_pool);
+	pthread_key_create(&delta_key, release_property_pool);
+}
+
+static indigo_property *acquire_pooled_storage(pthread_key_t key, long size) {
+	property_pool *pool = pthread_getspecific(key);
+	if (pool == NULL) {
+		pool = malloc(sizeof(property_pool));
+		assert(pool != NULL);
+		memset(pool, 0, sizeof(property_pool));
+		pthread_setspecific(key, pool);
+	}
+	if (pool->busy) {
+		// nested use from a bus callback, don't clobber the pooled one
+		indigo_property *property = malloc(size);
+		assert(property != NULL);
+		return property;
+	}
+	if (pool->property == NULL || pool->size < size) {
+		pool->property = realloc(pool->property, size);
+		assert(pool->property != NULL);
+		pool->size = size;
+	}
+	pool->busy = true;
+	return pool->property;
+}
+
+static indigo_property *acquire_pooled_property(pthread_key_t key, int count) {
+	return acquire_pooled_storage(key, sizeof(indigo_property) + count * sizeof(indigo_item));
+}
+
+static void release_pooled_property(pthread_key_t key, indigo_property *property) {
+	property_pool *pool = pthread_getspecific(key);
+	if (pool != NULL && pool->property == property)
+		pool->busy = false;
+	else
+		free(property);
+}
+
+/* address of thread local token identifies writer thread, readers never wait for section opened by themselves */
+
+static __thread char writer_token;
+
+/* property broadcasted by its writer, so clients can read it directly */
+
+static __thread indigo_property *published_property = NULL;
+
+static bool write_in_progress(indigo_property *property) {
+	return __atomic_load_n(&property->sequence, __ATOMIC_RELAXED) & 1;
+}
+
+static bool write_owned(indigo_property *property) {
+	return __atomic_load_n(&property->writer, __ATOMIC_RELAXED) == &writer_token;
+}
+
+void indigo_begin_property_write(indigo_property *property) {
+	assert(property != NULL);
+	// writers are serialized, so the section already opened by the same writer is just kept open
+	if (!write_in_progress(property)) {
+		__atomic_store_n(&property->writer, &writer_token, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&property->sequence, 1, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+	}
+}
+
+void indigo_end_property_write(indigo_property *property) {
+	assert(property != NULL);
+	if (write_in_progress(property)) {
+		__atomic_store_n(&property->writer, NULL, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&property->sequence, 1, __ATOMIC_RELEASE);
+	}
+}
+
+/* close section opened by current thread (section of other writer is left intact), update also swaps double buffered arrays; returns true if current thread is the writer */
+
+static bool finish_property_write(indigo_property *property, bool publish) {
+	bool owned = write_owned(property);
+	if (publish && (owned || !write_in_progress(property))) {
+		indigo_begin_property_write(property);
+		if (property->type == INDIGO_ARRAY_VECTOR) {
+			for (int i = 0; i < property->count; i++) {
+				indigo_item *item = property->items + i;
+				if (item->array.buffer != NULL) {
+					void *value = item->array.value;
+					item->array.value = item->array.buffer;
+					item->array.buffer = value;
+				}
+			}
+		}
+		owned = true;
+	}
+	if (owned)
+		indigo_end_property_write(property);
+	return owned;
+}
+
+static indigo_property *begin_broadcast(indigo_property *property, bool publish) {
+	indigo_property *previous = published_property;
+	if (finish_property_write(property, publish))
+		published_property = property;
+	return previous;
+}
+
+static void end_broadcast(indigo_property *previous) {
+	published_property = previous;
+}
+
+static long array_data_size(indigo_property *property, int index, int count) {
+	long size = 0;
+	if (property->type == INDIGO_ARRAY_VECTOR) {
+		for (int i = index; i < index + count; i++) {
+			indigo_item *item = property->items + i;
+			if (item->array.value != NULL)
+				size += item->array.count * indigo_array_element_size(item->array.type);
+		}
+	}
+	return size;
+}
+
+/* data_size is space reserved for array elements behind items, they are not copied if it is negative */
+
+#define COPY_RETRIES	100
+
+static bool copy_property(indigo_property *property, indigo_property *copy, int index, int count, long data_size) {
+	unsigned sequence;
+	int copied, retries = 0;
+	bool complete;
+	do {
+		complete = true;
+		// section of other writer is waited for only for limited time, slow writer may leave mix of old and new values
+		while (((sequence = __atomic_load_n(&property->sequence, __ATOMIC_ACQUIRE)) & 1) && !write_owned(property) && retries++ < COPY_RETRIES)
+			sched_yield();
+		memcpy(copy, property, sizeof(indigo_property));
+		copied = count;
+		if (index + copied > copy->count)
+			copied = copy->count > index ? copy->count - index : 0;
+		memcpy(copy->items, property->items + index, copied * sizeof(indigo_item));
+		if (data_size >= 0 && copy->type == INDIGO_ARRAY_VECTOR) {
+			// array elements are copied behind the items
+			char *data = (char *)(copy->items + count);
+			long available = data_size;
+			for (int i = 0; i < copied; i++) {
+				indigo_item *item = copy->items + i;
+				item->array.buffer = NULL;
+				if (item->array.value == NULL)
+					continue;
+				long size = item->array.count * indigo_array_element_size(item->array.type);
+				if (size > available) {
+					complete = false;
+					break;
+				}
+				memcpy(data, item->array.value, size);
+				item->array.value = data;
+				data += size;
+				available -= size;
+			}
+		}
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while (__atomic_load_n(&property->sequence, __ATOMIC_RELAXED) != sequence && retries++ < COPY_RETRIES);
+	copy->count = copied;
+	copy->sequence = 0;
+	copy->writer = NULL;
+	return complete;
+}
+
+indigo_property *indigo_acquire_property_snapshot(indigo_property *property) {
+	assert(property != NULL);
+	if (property->type == INDIGO_BLOB_VECTOR || property == published_property || __atomic_load_n(&property->sequence, __ATOMIC_ACQUIRE) == 0)
+		return property;
+	pthread_once(&property_pool_once, create_property_pool_keys);
+	while (true) {
+		int count = property->count;
+		long data_size = array_data_size(property, 0, count);
+		indigo_property *snapshot = acquire_pooled_storage(snapshot_key, sizeof(indigo_property) + count * sizeof(indigo_item) + data_size);
+		if (copy_property(property, snapshot, 0, count, data_size))
+			return snapshot;
+		// array was reshaped while being copied
+		release_pooled_property(snapshot_key, snapshot);
+	}
+}
+
+void indigo_release_property_snapshot(indigo_property *property, indigo_property *snapshot) {
+	assert(snapshot != NULL);
+	if (snapshot != property)
+		release_pooled_property(snapshot_key, snapshot);
+}
+
 indigo_result indigo_start() {
 	for (int i = 1; i < indigo_main_argc; i++) {
 		if (!strcmp(indigo_main_argv[i], "-v") || !strcmp(indigo_main_argv[i], "--enable-log")) {
@@ -375,15 +597,29 @@ indigo_result indigo_define_property(indigo_device *device, indigo_property *pro
 			va_end(args);
 		}
 		property->version = device ? device->version : INDIGO_VERSION_CURRENT;
+		indigo_property *previous = begin_broadcast(property, false);
 		for (int i = 0; i < MAX_CLIENTS; i++) {
 			indigo_client *client = clients[i];
 			if (client != NULL && client->define_property != NULL)
 				client->last_result = client->define_property(client, device, property, format != NULL ? message : NULL);
 		}
+		end_broadcast(previous);
 	}
 	return INDIGO_OK;
 }
 
+/* full size encoded BLOB is worth of sharing only if there can be more than one client receiving it inline */
+
+static int blob_consumers() {
+	int count = 0;
+	for (int i = 0; i < MAX_CLIENTS; i++) {
+		indigo_client *client = clients[i];
+		if (client != NULL && client->update_property != NULL && (client->enable_blob == INDIGO_ENABLE_BLOB_ALSO || client->enable_blob == INDIGO_ENABLE_BLOB_ONLY))
+			count++;
+	}
+	return count;
+}
+
 indigo_result indigo_update_property(indigo_device *device, indigo_property *property, const char *format, ...) {
 	assert(property != NULL);
 	if (!property->hidden) {
@@ -396,11 +632,15 @@ indigo_result indigo_update_property(indigo_device *device, indigo_property *pro
 			va_end(args);
 		}
 		property->version = device ? device->version : INDIGO_VERSION_CURRENT;
+		indigo_property *previous = begin_broadcast(property, true);
+		unsigned long shared_output = indigo_begin_shared_output(property->type != INDIGO_BLOB_VECTOR || blob_consumers() > 1);
 		for (int i = 0; i < MAX_CLIENTS; i++) {
 			indigo_client *client = clients[i];
 			if (client != NULL && client->update_property != NULL)
 				client->last_result = client->update_property(client, device, property, format != NULL ? message : NULL);
 		}
+		indigo_end_shared_output(shared_output);
+		end_broadcast(previous);
 	}
 	return INDIGO_OK;
 }
@@ -417,15 +657,96 @@ indigo_result indigo_delete_property(indigo_device *device, indigo_property *pro
 			va_end(args);
 		}
 		property->version = device ? device->version : INDIGO_VERSION_CURRENT;
+		indigo_property *previous = begin_broadcast(property, false);
 		for (int i = 0; i < MAX_CLIENTS; i++) {
 			indigo_client *client = clients[i];
 			if (client != NULL && client->delete_property != NULL)
 				client->last_result = client->delete_property(client, device, property, format != NULL ? message : NULL);
 		}
+		end_broadcast(previous);
 	}
 	return INDIGO_OK;
 }
 
+indigo_result indigo_define_property_items(indigo_device *device, indigo_property *property, int index, int count, const char *format, ...) {
+	assert(property != NULL);
+	assert(index >= 0 && count >= 0 && index + count <= property->count);
+	if (!property->hidden) {
+		char message[INDIGO_VALUE_SIZE];
+		if (format != NULL) {
+			va_list args;
+			va_start(args, format);
+			vsnprintf(message, INDIGO_VALUE_SIZE, format, args);
+			va_end(args);
+		}
+		property->version = device ? device->version : INDIGO_VERSION_CURRENT;
+		if (property->type == INDIGO_BLOB_VECTOR) {
+			// BLOB item addresses are used as download handles, redefine whole vector
+			indigo_delete_property(device, property, NULL);
+			return indigo_define_property(device, property, format != NULL ? "%s" : NULL, message);
+		}
+		pthread_once(&property_pool_once, create_property_pool_keys);
+		indigo_property *previous = begin_broadcast(property, false);
+		indigo_property *items = acquire_pooled_property(delta_key, count);
+		copy_property(property, items, index, count, -1);
+		INDIGO_DEBUG(indigo_debug_property("INDIGO Bus: property items definition", items, true, true));
+		for (int i = 0; i < MAX_CLIENTS; i++) {
+			indigo_client *client = clients[i];
+			if (client == NULL)
+				continue;
+			if (client->define_property_items != NULL)
+				client->last_result = client->define_property_items(client, device, property, items, format != NULL ? message : NULL);
+			else if (client->define_property != NULL)
+				client->last_result = client->define_property(client, device, property, format != NULL ? message : NULL);
+		}
+		release_pooled_property(delta_key, items);
+		end_broadcast(previous);
+	}
+	return INDIGO_OK;
+}
+
+indigo_result indigo_delete_property_items(indigo_device *device, indigo_property *property, int index, int count, const char *format, ...) {
+	assert(property != NULL);
+	assert(index >= 0 && count >= 0 && index + count <= property->count);
+	char message[INDIGO_VALUE_SIZE];
+	if (format != NULL) {
+		va_list args;
+		va_start(args, format);
+		vsnprintf(message, INDIGO_VALUE_SIZE, format, args);
+		va_end(args);
+	}
+	pthread_once(&property_pool_once, create_property_pool_keys);
+	indigo_property *previous = begin_broadcast(property, false);
+	indigo_property *items = acquire_pooled_property(delta_key, count);
+	copy_property(property, items, index, count, -1);
+	bool nested = write_in_progress(property);
+	indigo_begin_property_write(property);
+	memmove(property->items + index, property->items + index + count, (property->count - index - count) * sizeof(indigo_item));
+	property->count -= count;
+	if (!nested)
+		indigo_end_property_write(property);
+	if (!property->hidden) {
+		INDIGO_DEBUG(indigo_debug_property("INDIGO Bus: property items removal", items, false, true));
+		property->version = items->version = device ? device->version : INDIGO_VERSION_CURRENT;
+		for (int i = 0; i < MAX_CLIENTS; i++) {
+			indigo_client *client = clients[i];
+			if (client == NULL)
+				continue;
+			if (client->delete_property_items != NULL) {
+				client->last_result = client->delete_property_items(client, device, property, items, format != NULL ? message : NULL);
+			} else {
+				if (client->delete_property != NULL)
+					client->last_result = client->delete_property(client, device, property, NULL);
+				if (client->define_property != NULL)
+					client->last_result = client->define_property(client, device, property, format != NULL ? message : NULL);
+			}
+		}
+	}
+	release_pooled_property(delta_key, items);
+	end_broadcast(previous);
+	return INDIGO_OK;
+}
+
 indigo_result indigo_send_message(indigo_device *device, const char *format, ...) {
 	INDIGO_DEBUG(indigo_debug("INDIGO Bus: message sent"));
 	char message[INDIGO_VALUE_SIZE];
@@ -573,6 +894,27 @@ indigo_property *indigo_init_blob_property(indigo_property *property, const char
 	return property;
 }
 
+indigo_property *indigo_init_array_property(indigo_property *property, const char *device, const char *name, const char *group, const char *label, indigo_property_state state, int count) {
+	assert(device != NULL);
+	assert(name != NULL);
+	int size = sizeof(indigo_property) + count * sizeof(indigo_item);
+	if (property == NULL) {
+		property = malloc(size);
+		assert(property != NULL);
+	}
+	memset(property, 0, size);
+	strncpy(property->device, device, INDIGO_NAME_SIZE);
+	strncpy(property->name, name, INDIGO_NAME_SIZE);
+	strncpy(property->group, group ? group : "", INDIGO_NAME_SIZE);
+	strncpy(property->label, label ? label : "", INDIGO_VALUE_SIZE);
+	property->type = INDIGO_ARRAY_VECTOR;
+	property->perm = INDIGO_RO_PERM;
+	property->state = state;
+	property->version = INDIGO_VERSION_CURRENT;
+	property->count = count;
+	return property;
+}
+
 indigo_property *indigo_resize_property(indigo_property *property, int count) {
 	assert(property != NULL);
 	property = realloc(property, sizeof(indigo_property) + count * sizeof(indigo_item));
@@ -658,6 +1000,57 @@ void indigo_init_blob_item(indigo_item *item, const char *name, const char *labe
 	strncpy(item->label, label ? label : "", INDIGO_VALUE_SIZE);
 }
 
+void indigo_init_array_item(indigo_item *item, const char *name, const char *label, indigo_array_type type) {
+	assert(item != NULL);
+	assert(name != NULL);
+	memset(item, 0, sizeof(indigo_item));
+	strncpy(item->name, name, INDIGO_NAME_SIZE);
+	strncpy(item->label, label ? label : "", INDIGO_VALUE_SIZE);
+	item->array.type = type;
+}
+
+void indigo_set_array_item_value(indigo_item *item, void *value, int rank, ...) {
+	assert(item != NULL);
+	assert(rank >= 0 && rank <= INDIGO_MAX_ARRAY_RANK);
+	va_list args;
+	va_start(args, rank);
+	long count = rank > 0 ? 1 : 0;
+	for (int i = 0; i < rank; i++)
+		count *= (item->array.shape[i] = va_arg(args, int));
+	va_end(args);
+	item->array.rank = rank;
+	item->array.count = count;
+	item->array.value = value;
+	item->array.buffer = NULL;
+}
+
+void indigo_set_array_item_buffers(indigo_item *item, void *value, void *buffer, int rank, ...) {
+	assert(item != NULL);
+	assert(rank >= 0 && rank <= INDIGO_MAX_ARRAY_RANK);
+	va_list args;
+	va_start(args, rank);
+	long count = rank > 0 ? 1 : 0;
+	for (int i = 0; i < rank; i++)
+		count *= (item->array.shape[i] = va_arg(args, int));
+	va_end(args);
+	item->array.rank = rank;
+	item->array.count = count;
+	item->array.value = value;
+	item->array.buffer = buffer;
+}
+
+int indigo_array_element_size(indigo_array_type type) {
+	switch (type) {
+		case INDIGO_ARRAY_DOUBLE:
+			return sizeof(double);
+		case INDIGO_ARRAY_FLOAT:
+			return sizeof(float);
+		case INDIGO_ARRAY_INT32:
+			return sizeof(int32_t);
+	}
+	return 0;
+}
+
 void *indigo_alloc_blob_buffer(long size) {
 	int mod2880 = size % 2880;
 	if (mod2880) {
@@ -757,12 +1150,16 @@ bool indigo_switch_match(indigo_item *item, indigo_property *other) {
 void indigo_set_switch(indigo_property *property, indigo_item *item, bool value) {
 	assert(property != NULL);
 	assert(property->type == INDIGO_SWITCH_VECTOR);
+	bool nested = write_in_progress(property);
+	indigo_begin_property_write(property);
 	if (property->rule != INDIGO_ANY_OF_MANY_RULE) {
 		for (int i = 0; i < property->count; i++) {
 			property->items[i].sw.value = false;
 		}
 	}
 	item->sw.value = value;
+	if (!nested)
+		indigo_end_property_write(property);
 }
 
 bool indigo_get_switch(indigo_property *property, char *item_name) {
@@ -780,6 +1177,8 @@ void indigo_property_copy_values(indigo_property *property, indigo_property *oth
 	assert(other != NULL);
 	if (property->perm == INDIGO_RW_PERM) {
 		if (property->type == other->type) {
+			bool nested = write_in_progress(property);
+			indigo_begin_property_write(property);
 			if (with_state)
 				property->state = other->state;
 			if (property->type == INDIGO_SWITCH_VECTOR && property->rule != INDIGO_ANY_OF_MANY_RULE) {
@@ -787,11 +1186,15 @@ void indigo_property_copy_values(indigo_property *property, indigo_property *oth
 					property->items[j].sw.value = false;
 				}
 			}
+			int next = 0;
 			for (int i = 0; i < other->count; i++) {
 				indigo_item *other_item = &other->items[i];
-				for (int j = 0; j < property->count; j++) {
+				/* items usually come in the same order, so the search starts behind the last match */
+				for (int k = 0; k < property->count; k++) {
+					int j = (next + k) % property->count;
 					indigo_item *property_item = &property->items[j];
 					if (!strcmp(property_item->name, other_item->name)) {
+						next = j + 1;
 						switch (property->type) {
 						case INDIGO_TEXT_VECTOR:
 							strncpy(property_item->text.value, other_item->text.value, INDIGO_VALUE_SIZE);
@@ -815,39 +1218,83 @@ void indigo_property_copy_values(indigo_property *property, indigo_property *oth
 							property_item->blob.size = other_item->blob.size;
 							property_item->blob.value = other_item->blob.value;
 							break;
+						case INDIGO_ARRAY_VECTOR: {
+							void *buffer = property_item->array.buffer;
+							property_item->array = other_item->array;
+							property_item->array.buffer = buffer;
+							break;
+						}
 						}
 						break;
 					}
 				}
 			}
+			if (!nested)
+				indigo_end_property_write(property);
 		}
 	}
 }
 
+static indigo_property *acquire_change_request(indigo_property_type type, const char *device, const char *name, int count) {
+	assert(device != NULL);
+	assert(name != NULL);
+	pthread_once(&property_pool_once, create_property_pool_keys);
+	indigo_property *property = acquire_pooled_property(change_request_key, count);
+	memset(property, 0, sizeof(indigo_property));
+	strncpy(property->device, device, INDIGO_NAME_SIZE);
+	strncpy(property->name, name, INDIGO_NAME_SIZE);
+	property->type = type;
+	property->version = INDIGO_VERSION_CURRENT;
+	property->count = count;
+	return property;
+}
+
+static void release_change_request(indigo_property *property) {
+	release_pooled_property(change_request_key, property);
+}
+
+static void init_change_request_item(indigo_item *item, const char *name) {
+	assert(name != NULL);
+	strncpy(item->name, name, INDIGO_NAME_SIZE);
+	*item->label = 0;
+}
+
 indigo_result indigo_change_text_property(indigo_client *client, const char *device, const char *name, int count, const char **items, const char **values) {
-	indigo_property *property = indigo_init_text_property(NULL, device, name, NULL, NULL, 0, 0, count);
-	for (int i = 0; i < count; i++)
-		indigo_init_text_item(&property->items[i], items[i], NULL, values[i]);
+	indigo_property *property = acquire_change_request(INDIGO_TEXT_VECTOR, device, name, count);
+	for (int i = 0; i < count; i++) {
+		indigo_item *item = &property->items[i];
+		init_change_request_item(item, items[i]);
+		strncpy(item->text.value, values[i], INDIGO_VALUE_SIZE);
+		item->text.value[INDIGO_VALUE_SIZE - 1] = 0;
+	}
 	indigo_result result = indigo_change_property(client, property);
-	free(property);
+	release_change_request(property);
 	return result;
 }
 
 indigo_result indigo_change_number_property(indigo_client *client, const char *device, const char *name, int count, const char **items, const double *values) {
-	indigo_property *property = indigo_init_number_property(NULL, device, name, NULL, NULL, 0, 0, count);
-	for (int i = 0; i < count; i++)
-		indigo_init_number_item(&property->items[i], items[i], NULL, 0, 0, 0, values[i]);
+	indigo_property *property = acquire_change_request(INDIGO_NUMBER_VECTOR, device, name, count);
+	for (int i = 0; i < count; i++) {
+		indigo_item *item = &property->items[i];
+		init_change_request_item(item, items[i]);
+		strcpy(item->number.format, "%g");
+		item->number.min = item->number.max = item->number.step = 0;
+		item->number.target = item->number.value = values[i];
+	}
 	indigo_result result = indigo_change_property(client, property);
-	free(property);
+	release_change_request(property);
 	return result;
 }
 
 indigo_result indigo_change_switch_property(indigo_client *client, const char *device, const char *name, int count, const char **items, const bool *values) {
-	indigo_property *property = indigo_init_switch_property(NULL, device, name, NULL, NULL, 0, 0, 0, count);
-	for (int i = 0; i < count; i++)
-		indigo_init_switch_item(&property->items[i], items[i], NULL, values[i]);
+	indigo_property *property = acquire_change_request(INDIGO_SWITCH_VECTOR, device, name, count);
+	for (int i = 0; i < count; i++) {
+		indigo_item *item = &property->items[i];
+		init_change_request_item(item, items[i]);
+		item->sw.value = values[i];
+	}
 	indigo_result result = indigo_change_property(client, property);
-	free(property);
+	release_change_request(property);
 	return result;
 }
 
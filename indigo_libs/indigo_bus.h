@@ -27,6 +27,7 @@
 #define indigo_bus_h
 
 #include <stdbool.h>
+#include <pthread.h>
 
 #include "indigo_config.h"
 
@@ -76,7 +77,8 @@ typedef enum {
 	INDIGO_NUMBER_VECTOR,       ///< float numbers with defined min, max values and increment
 	INDIGO_SWITCH_VECTOR,       ///< logical values representing “on” and “off” state
 	INDIGO_LIGHT_VECTOR,        ///< status values with four possible values INDIGO_IDLE_STATE, INDIGO_OK_STATE, INDIGO_BUSY_STATE and INDIGO_ALERT_STATE
-	INDIGO_BLOB_VECTOR          ///< binary data of any type and any length
+	INDIGO_BLOB_VECTOR,         ///< binary data of any type and any length
+	INDIGO_ARRAY_VECTOR         ///< typed numeric arrays with shape (INDIGO_VERSION_2_0 clients only)
 } indigo_property_type;
 
 /** Textual representations of indigo_property_type values.
@@ -120,6 +122,22 @@ typedef enum {
  */
 extern char *indigo_switch_rule_text[];
 
+/** Array item element type.
+ */
+typedef enum {
+	INDIGO_ARRAY_DOUBLE = 1,    ///< 64-bit IEEE 754 floating point numbers
+	INDIGO_ARRAY_FLOAT,         ///< 32-bit IEEE 754 floating point numbers
+	INDIGO_ARRAY_INT32          ///< 32-bit signed integers
+} indigo_array_type;
+
+/** Textual representation of indigo_array_type values.
+ */
+extern char *indigo_array_type_text[];
+
+/** Max number of array item dimensions.
+ */
+#define INDIGO_MAX_ARRAY_RANK	4
+
 typedef enum {
 	INDIGO_ENABLE_BLOB_ALSO,
 	INDIGO_ENABLE_BLOB_NEVER,
@@ -166,6 +184,16 @@ typedef struct {
 			long size;                      ///< item size (for blob properties) in bytes
 			void *value;                    ///< item value (for blob properties)
 		} blob;
+		/** Array property item specific fields.
+		 */
+		struct {
+			indigo_array_type type;         ///< element type
+			int rank;                       ///< number of dimensions
+			int shape[INDIGO_MAX_ARRAY_RANK]; ///< dimensions, the last one varies fastest
+			long count;                     ///< number of elements (product of dimensions)
+			void *value;                    ///< elements in host byte order (little endian on the wire), owned by the device
+			void *buffer;                   ///< elements being prepared by the device, swapped with value by indigo_update_property() (NULL if item is not double buffered)
+		} array;
 	};
 } indigo_item;
 
@@ -182,6 +210,8 @@ typedef struct {
 	indigo_rule rule;                   ///< switch behaviour rule (for switch properties)
 	short version;                      ///< property version INDIGO_VERSION_NONE, INDIGO_VERSION_LEGACY or INDIGO_VERSION_2_0
 	bool hidden;                        ///< property is hidden/unused by  driver (for optional properties)
+	unsigned sequence;                  ///< item values write sequence (odd while write is in progress)
+	void *writer;                       ///< thread holding write section open (NULL if none)
 	int count;                          ///< number of property items
 	indigo_item items[];                ///< property items
 } indigo_property;
@@ -236,6 +266,12 @@ typedef struct indigo_client {
 	/** callback called when client is detached from the bus
 	 */
 	indigo_result (*detach)(indigo_client *client);
+	/** callback called when device broadcast definition of added or replaced items (items contains only affected items, property is complete), if NULL define_property is called instead
+	 */
+	indigo_result (*define_property_items)(indigo_client *client, struct indigo_device *device, indigo_property *property, indigo_property *items, const char *message);
+	/** callback called when device broadcast removal of items (items contains only removed items, property is complete), if NULL delete_property and define_property are called instead
+	 */
+	indigo_result (*delete_property_items)(indigo_client *client, struct indigo_device *device, indigo_property *property, indigo_property *items, const char *message);
 } indigo_client;
 
 /** Wire protocol adapter private data structure.
@@ -244,7 +280,11 @@ typedef struct {
 	int input;													///< input handle
 	int output;													///< output handle
 	bool web_socket;										///< connection over WebSocket (RFC6455)
+	struct indigo_ws_compression *compression;	///< WebSocket permessage-deflate state (NULL if not negotiated)
 	char url_prefix[INDIGO_NAME_SIZE];	///< server url prefix (for BLOB download)
+	struct indigo_output_buffer *output_buffer;	///< buffered output
+	bool raw_blobs;											///< BLOB data are sent as raw bytes (negotiated between INDIGO peers)
+	pthread_mutex_t output_mutex;				///< output serialization lock
 } indigo_adapter_context;
 
 
@@ -299,10 +339,12 @@ extern indigo_result indigo_attach_client(indigo_client *client);
 extern indigo_result indigo_detach_client(indigo_client *client);
 
 /** Broadcast property definition.
+ Write section opened by the calling thread is finished before broadcast.
  */
 extern indigo_result indigo_define_property(indigo_device *device, indigo_property *property, const char *format, ...);
 
 /** Broadcast property value change.
+ Write section opened by the calling thread is finished and double buffered array items are swapped before broadcast, clients then serialize property without copying it.
  */
 extern indigo_result indigo_update_property(indigo_device *device, indigo_property *property, const char *format, ...);
 
@@ -310,6 +352,14 @@ extern indigo_result indigo_update_property(indigo_device *device, indigo_proper
  */
 extern indigo_result indigo_delete_property(indigo_device *device, indigo_property *property, const char *format, ...);
 
+/** Broadcast definition of items property->items[index] ... property->items[index + count - 1] added to or replaced in already defined property.
+ */
+extern indigo_result indigo_define_property_items(indigo_device *device, indigo_property *property, int index, int count, const char *format, ...);
+
+/** Remove items property->items[index] ... property->items[index + count - 1] from property and broadcast their removal.
+ */
+extern indigo_result indigo_delete_property_items(indigo_device *device, indigo_property *property, int index, int count, const char *format, ...);
+
 /** Broadcast message.
  */
 extern indigo_result indigo_send_message(indigo_device *device, const char *format, ...);
@@ -342,6 +392,9 @@ extern indigo_property *indigo_init_light_property(indigo_property *property, co
 /** Initialize BLOB property.
  */
 extern indigo_property *indigo_init_blob_property(indigo_property *property, const char *device, const char *name, const char *group, const char *label, indigo_property_state state, int count);
+/** Initialize array property.
+ */
+extern indigo_property *indigo_init_array_property(indigo_property *property, const char *device, const char *name, const char *group, const char *label, indigo_property_state state, int count);
 /** Resize property.
  */
 extern indigo_property *indigo_resize_property(indigo_property *property, int count);
@@ -370,6 +423,18 @@ extern void indigo_init_light_item(indigo_item *item, const char *name, const ch
 /** Initialize BLOB item.
  */
 extern void indigo_init_blob_item(indigo_item *item, const char *name, const char *label);
+/** Initialize array item.
+ */
+extern void indigo_init_array_item(indigo_item *item, const char *name, const char *label, indigo_array_type type);
+/** Set array item value and shape (count of dimensions is given by rank, buffer is not copied).
+ */
+extern void indigo_set_array_item_value(indigo_item *item, void *value, int rank, ...);
+/** Set array item shape and two device owned buffers of the same size, device fills buffer and indigo_update_property() publishes it by swapping it with value.
+ */
+extern void indigo_set_array_item_buffers(indigo_item *item, void *value, void *buffer, int rank, ...);
+/** Size of single array element in bytes.
+ */
+extern int indigo_array_element_size(indigo_array_type type);
 
 /** populate BLOB item if url is given. 
  */ 
@@ -395,15 +460,36 @@ extern bool indigo_get_switch(indigo_property *property, char *item_name);
  */
 extern void indigo_property_copy_values(indigo_property *property, indigo_property *other, bool with_state);
 
+/** Mark start of property item values modification.
+ Writers of the same property must be serialized, readers never block them and wait for them only for limited time. Modification is finished by indigo_end_property_write() or by any broadcast of the property from the same thread, nested calls are ignored.
+ */
+extern void indigo_begin_property_write(indigo_property *property);
+
+/** Mark end of property item values modification.
+ */
+extern void indigo_end_property_write(indigo_property *property);
+
+/** Get consistent copy of property for serialization (or property itself if it is broadcasted by its writer, was never modified between indigo_begin_property_write() and indigo_end_property_write() or if it is BLOB vector).
+ Array elements are copied with items.
+ */
+extern indigo_property *indigo_acquire_property_snapshot(indigo_property *property);
+
+/** Release snapshot acquired by indigo_acquire_property_snapshot().
+ */
+extern void indigo_release_property_snapshot(indigo_property *property, indigo_property *snapshot);
+
 /** Request text property change.
+ Request is built in per-thread reusable storage, so repeated calls do not allocate.
  */
 extern indigo_result indigo_change_text_property(indigo_client *client, const char *device, const char *name, int count, const char **items, const char **values);
 
 /** Request number property change.
+ Request is built in per-thread reusable storage, so repeated calls do not allocate.
  */
 extern indigo_result indigo_change_number_property(indigo_client *client, const char *device, const char *name, int count, const char **items, const double *values);
 
 /** Request switch property change.
+ Request is built in per-thread reusable storage, so repeated calls do not allocate.
  */
 extern indigo_result indigo_change_switch_property(indigo_client *client, const char *device, const char *name, int count, const char **items, const bool *values);
 
@@ -40,10 +40,17 @@
 #include <signal.h>
 #include <assert.h>
 
+#if defined(INDIGO_FREEBSD)
+#include <libusb.h>
+#else
+#include <libusb-1.0/libusb.h>
+#endif
+
 #include "indigo_client_xml.h"
 #include "indigo_client.h"
 
 static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t activate_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 indigo_driver_entry indigo_available_drivers[INDIGO_MAX_DRIVERS];
 indigo_server_entry indigo_available_servers[INDIGO_MAX_SERVERS];
@@ -53,37 +60,51 @@ static int used_driver_slots = 0;
 static int used_server_slots = 0;
 static int used_subprocess_slots = 0;
 
-static indigo_result add_driver(driver_entry_point entry_point, void *dl_handle, bool init, indigo_driver_entry **driver) {
+static void fill_driver_entry(indigo_driver_entry *entry, driver_entry_point entry_point, void *dl_handle) {
+	indigo_driver_info info;
+	entry_point(INDIGO_DRIVER_INFO, &info);
+	strncpy(entry->description, info.description, INDIGO_NAME_SIZE); //TO BE CHANGED - DRIVER SHOULD REPORT NAME!!!
+	strncpy(entry->name, info.name, INDIGO_NAME_SIZE);
+	entry->driver = entry_point;
+	entry->dl_handle = dl_handle;
+	INDIGO_LOG(indigo_log("Driver %s %d.%d.%d.%d loaded", info.name, INDIGO_VERSION_MAJOR(INDIGO_VERSION_CURRENT), INDIGO_VERSION_MINOR(INDIGO_VERSION_CURRENT), INDIGO_VERSION_MAJOR(info.version), INDIGO_VERSION_MINOR(info.version)));
+}
+
+static int find_driver_slot(driver_entry_point entry_point, const char *name) {
 	int empty_slot = used_driver_slots; /* the first slot after the last used is a good candidate */
-	pthread_mutex_lock(&mutex);
 	for (int dc = 0; dc < used_driver_slots;  dc++) {
-		if (indigo_available_drivers[dc].driver == entry_point) {
-			INDIGO_LOG(indigo_log("Driver %s already loaded", indigo_available_drivers[dc].name));
-			if (dl_handle != NULL)
-				dlclose(dl_handle);
-			if (driver != NULL)
-				*driver = &indigo_available_drivers[dc];
-			pthread_mutex_unlock(&mutex);
-			return INDIGO_DUPLICATED;
-		} else if (indigo_available_drivers[dc].driver == NULL) {
+		indigo_driver_entry *entry = &indigo_available_drivers[dc];
+		if ((entry_point != NULL && entry->driver == entry_point) || (name != NULL && entry->driver == NULL && *entry->path && !strcmp(entry->name, name))) {
+			return -dc - 1;
+		} else if (entry->driver == NULL && *entry->path == 0) {
 			empty_slot = dc; /* if there is a gap - fill it */
 		}
 	}
+	return empty_slot;
+}
+
+static indigo_result add_driver(driver_entry_point entry_point, void *dl_handle, bool init, indigo_driver_entry **driver) {
+	pthread_mutex_lock(&mutex);
+	int empty_slot = find_driver_slot(entry_point, NULL);
+	if (empty_slot < 0) {
+		empty_slot = -empty_slot - 1;
+		INDIGO_LOG(indigo_log("Driver %s already loaded", indigo_available_drivers[empty_slot].name));
+		if (dl_handle != NULL)
+			dlclose(dl_handle);
+		if (driver != NULL)
+			*driver = &indigo_available_drivers[empty_slot];
+		pthread_mutex_unlock(&mutex);
+		return INDIGO_DUPLICATED;
+	}
 
-	if (empty_slot > INDIGO_MAX_DRIVERS) {
+	if (empty_slot >= INDIGO_MAX_DRIVERS) {
 		if (dl_handle != NULL)
 			dlclose(dl_handle);
 		pthread_mutex_unlock(&mutex);
 		return INDIGO_TOO_MANY_ELEMENTS; /* no emty slot found, list is full */
 	}
 
-	indigo_driver_info info;
-	entry_point(INDIGO_DRIVER_INFO, &info);
-	strncpy(indigo_available_drivers[empty_slot].description, info.description, INDIGO_NAME_SIZE); //TO BE CHANGED - DRIVER SHOULD REPORT NAME!!!
-	strncpy(indigo_available_drivers[empty_slot].name, info.name, INDIGO_NAME_SIZE);
-	indigo_available_drivers[empty_slot].driver = entry_point;
-	indigo_available_drivers[empty_slot].dl_handle = dl_handle;
-	INDIGO_LOG(indigo_log("Driver %s %d.%d.%d.%d loaded", info.name, INDIGO_VERSION_MAJOR(INDIGO_VERSION_CURRENT), INDIGO_VERSION_MINOR(INDIGO_VERSION_CURRENT), INDIGO_VERSION_MAJOR(info.version), INDIGO_VERSION_MINOR(info.version)));
+	fill_driver_entry(&indigo_available_drivers[empty_slot], entry_point, dl_handle);
 
 	if (empty_slot == used_driver_slots)
 		used_driver_slots++; /* if we are not filling a gap - increase used_slots */
@@ -103,15 +124,20 @@ static indigo_result add_driver(driver_entry_point entry_point, void *dl_handle,
 indigo_result indigo_remove_driver(indigo_driver_entry *driver) {
 	assert(driver != NULL);
 	pthread_mutex_lock(&mutex);
-	driver->driver(INDIGO_DRIVER_SHUTDOWN, NULL); /* deregister */
+	if (driver->driver) {
+		driver->driver(INDIGO_DRIVER_SHUTDOWN, NULL); /* deregister */
+		INDIGO_LOG(indigo_log("Driver %s unloaded", driver->name));
+	}
 	if (driver->dl_handle) {
 		dlclose(driver->dl_handle);
 	}
-	INDIGO_LOG(indigo_log("Driver %s unloaded", driver->name));
 	driver->description[0] = '\0';
 	driver->name[0] = '\0';
+	driver->path[0] = '\0';
 	driver->driver = NULL;
 	driver->dl_handle = NULL;
+	driver->initialized = false;
+	memset(driver->usb_vendors, 0, sizeof(driver->usb_vendors));
 	pthread_mutex_unlock(&mutex);
 	return INDIGO_OK;
 }
@@ -126,39 +152,173 @@ indigo_result indigo_add_driver(driver_entry_point entry_point, bool init, indig
 #define SO_NAME ".so"
 #endif
 
-indigo_result indigo_load_driver(const char *name, bool init, indigo_driver_entry **driver) {
+static void split_driver_name(const char *name, char *entry_point_name, char *so_name) {
 	char driver_name[INDIGO_NAME_SIZE];
-	char so_name[INDIGO_NAME_SIZE];
-	char *entry_point_name, *cp;
-	void *dl_handle;
-	driver_entry_point entry_point;
-
 	strncpy(driver_name, name, sizeof(driver_name));
-	strncpy(so_name, name, sizeof(so_name));
-
-	entry_point_name = basename(driver_name);
-	cp = strchr(entry_point_name, '.');
+	strncpy(so_name, name, INDIGO_NAME_SIZE);
+	strncpy(entry_point_name, basename(driver_name), INDIGO_NAME_SIZE);
+	char *cp = strchr(entry_point_name, '.');
 	if (cp)
 		*cp = '\0';
 	else
-		strncat(so_name, SO_NAME, INDIGO_NAME_SIZE);
+		strncat(so_name, SO_NAME, INDIGO_NAME_SIZE - strlen(so_name) - 1);
+}
 
-	dl_handle = dlopen(so_name, RTLD_LAZY);
-	if (!dl_handle) {
+static indigo_result open_driver(const char *so_name, const char *entry_point_name, driver_entry_point *entry_point, void **dl_handle) {
+	*dl_handle = dlopen(so_name, RTLD_LAZY);
+	if (!*dl_handle) {
 		const char* dlsym_error = dlerror();
 		INDIGO_ERROR(indigo_error("Driver %s can't be loaded (%s)", entry_point_name, dlsym_error));
 		return INDIGO_FAILED;
 	}
-	entry_point = dlsym(dl_handle, entry_point_name);
+	*entry_point = dlsym(*dl_handle, entry_point_name);
 	const char* dlsym_error = dlerror();
 	if (dlsym_error) {
 		INDIGO_ERROR(indigo_error("Can't load %s() (%s)", entry_point_name, dlsym_error));
-		dlclose(dl_handle);
+		dlclose(*dl_handle);
 		return INDIGO_NOT_FOUND;
 	}
+	return INDIGO_OK;
+}
+
+indigo_result indigo_load_driver(const char *name, bool init, indigo_driver_entry **driver) {
+	char entry_point_name[INDIGO_NAME_SIZE];
+	char so_name[INDIGO_NAME_SIZE];
+	void *dl_handle;
+	driver_entry_point entry_point;
+
+	split_driver_name(name, entry_point_name, so_name);
+	pthread_mutex_lock(&mutex);
+	int slot = find_driver_slot(NULL, entry_point_name);
+	pthread_mutex_unlock(&mutex);
+	if (slot < 0) {
+		/* driver is registered, load it in place */
+		indigo_driver_entry *entry = &indigo_available_drivers[-slot - 1];
+		if (driver != NULL)
+			*driver = entry;
+		return init ? indigo_activate_driver(entry) : INDIGO_OK;
+	}
+	indigo_result result = open_driver(so_name, entry_point_name, &entry_point, &dl_handle);
+	if (result != INDIGO_OK)
+		return result;
 	return add_driver(entry_point, dl_handle, init, driver);
 }
 
+indigo_result indigo_register_driver(const char *name, const uint16_t *usb_vendors, indigo_driver_entry **driver) {
+	char entry_point_name[INDIGO_NAME_SIZE];
+	char so_name[INDIGO_NAME_SIZE];
+	split_driver_name(name, entry_point_name, so_name);
+	pthread_mutex_lock(&mutex);
+	int slot = find_driver_slot(NULL, entry_point_name);
+	if (slot < 0) {
+		if (driver != NULL)
+			*driver = &indigo_available_drivers[-slot - 1];
+		pthread_mutex_unlock(&mutex);
+		return INDIGO_DUPLICATED;
+	}
+	if (slot >= INDIGO_MAX_DRIVERS) {
+		pthread_mutex_unlock(&mutex);
+		return INDIGO_TOO_MANY_ELEMENTS;
+	}
+	indigo_driver_entry *entry = &indigo_available_drivers[slot];
+	memset(entry, 0, sizeof(indigo_driver_entry));
+	strncpy(entry->description, entry_point_name, INDIGO_NAME_SIZE);
+	strncpy(entry->name, entry_point_name, INDIGO_NAME_SIZE);
+	strncpy(entry->path, so_name, INDIGO_NAME_SIZE);
+	if (usb_vendors != NULL)
+		memcpy(entry->usb_vendors, usb_vendors, sizeof(entry->usb_vendors));
+	if (slot == used_driver_slots)
+		used_driver_slots++;
+	pthread_mutex_unlock(&mutex);
+	INDIGO_LOG(indigo_log("Driver %s registered", entry->name));
+	if (driver != NULL)
+		*driver = entry;
+	return INDIGO_OK;
+}
+
+/* activated is set only if driver was initialized by this call */
+
+static indigo_result activate_driver(indigo_driver_entry *driver, bool *activated) {
+	assert(driver != NULL);
+	pthread_mutex_lock(&activate_mutex);
+	if (driver->initialized) {
+		pthread_mutex_unlock(&activate_mutex);
+		return INDIGO_OK;
+	}
+	if (driver->driver == NULL) {
+		if (*driver->path == 0) {
+			pthread_mutex_unlock(&activate_mutex);
+			return INDIGO_NOT_FOUND;
+		}
+		void *dl_handle;
+		driver_entry_point entry_point;
+		indigo_result result = open_driver(driver->path, driver->name, &entry_point, &dl_handle);
+		if (result != INDIGO_OK) {
+			pthread_mutex_unlock(&activate_mutex);
+			return result;
+		}
+		pthread_mutex_lock(&mutex);
+		fill_driver_entry(driver, entry_point, dl_handle);
+		pthread_mutex_unlock(&mutex);
+	}
+	indigo_result result = driver->driver(INDIGO_DRIVER_INIT, NULL);
+	driver->initialized = *activated = result == INDIGO_OK;
+	pthread_mutex_unlock(&activate_mutex);
+	return result;
+}
+
+indigo_result indigo_activate_driver(indigo_driver_entry *driver) {
+	bool activated = false;
+	return activate_driver(driver, &activated);
+}
+
+static void (*on_demand_callback)(indigo_driver_entry *driver) = NULL;
+
+static void *on_demand_activate(indigo_driver_entry *driver) {
+	bool activated = false;
+	activate_driver(driver, &activated);
+	pthread_mutex_lock(&mutex);
+	driver->activation_pending = false;
+	pthread_mutex_unlock(&mutex);
+	/* driver may be activated by explicit LOAD meanwhile */
+	if (activated) {
+		INDIGO_LOG(indigo_log("Driver %s activated on demand", driver->name));
+		if (on_demand_callback != NULL)
+			on_demand_callback(driver);
+	}
+	return NULL;
+}
+
+static int hotplug_callback(libusb_context *ctx, libusb_device *dev, libusb_hotplug_event event, void *user_data) {
+	struct libusb_device_descriptor descriptor;
+	if (libusb_get_device_descriptor(dev, &descriptor) != LIBUSB_SUCCESS)
+		return 0;
+	pthread_mutex_lock(&mutex);
+	for (int dc = 0; dc < used_driver_slots; dc++) {
+		indigo_driver_entry *entry = &indigo_available_drivers[dc];
+		if (entry->initialized || entry->activation_pending || (entry->driver == NULL && *entry->path == 0))
+			continue;
+		for (int i = 0; i < INDIGO_MAX_USB_VENDORS && entry->usb_vendors[i]; i++) {
+			if (entry->usb_vendors[i] == descriptor.idVendor) {
+				/* activation registers driver's own hotplug callbacks, it can't be done from here */
+				entry->activation_pending = true;
+				indigo_async((void *(*)(void *))on_demand_activate, entry);
+				break;
+			}
+		}
+	}
+	pthread_mutex_unlock(&mutex);
+	return 0;
+}
+
+void indigo_start_on_demand_activation(void (*callback)(indigo_driver_entry *driver)) {
+	static libusb_hotplug_callback_handle callback_handle;
+	on_demand_callback = callback;
+	indigo_start_usb_event_handler();
+	int rc = libusb_hotplug_register_callback(NULL, LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED, LIBUSB_HOTPLUG_ENUMERATE, LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY, hotplug_callback, NULL, &callback_handle);
+	INDIGO_DEBUG(indigo_debug("libusb_hotplug_register_callback() -> %s", rc < 0 ? libusb_error_name(rc) : "OK"));
+}
+
 void indigo_service_name(const char *host, int port, char *name) {
 	strncpy(name, host, INDIGO_NAME_SIZE);
 	char *lastone = name + strlen(name) - 1;
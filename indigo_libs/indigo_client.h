@@ -34,6 +34,7 @@
 
 #define INDIGO_MAX_DRIVERS    100
 #define INDIGO_MAX_SERVERS    10
+#define INDIGO_MAX_USB_VENDORS	4
 
 /** Driver entry type.
  */
@@ -43,6 +44,9 @@ typedef struct {
 	driver_entry_point driver;              ///< driver entry point
 	void *dl_handle;                        ///< dynamic library handle (NULL for statically linked driver)
 	bool initialized;												///< driver is initialized
+	char path[INDIGO_NAME_SIZE];            ///< shared library name (for registered but not yet loaded driver)
+	uint16_t usb_vendors[INDIGO_MAX_USB_VENDORS]; ///< USB vendor IDs triggering on demand activation (zero terminated)
+	bool activation_pending;                ///< on demand activation is scheduled
 } indigo_driver_entry;
 
 /** Remote server entry type.
@@ -91,6 +95,18 @@ extern indigo_result indigo_remove_driver(indigo_driver_entry *driver);
  */
 extern indigo_result indigo_load_driver(const char *name, bool init, indigo_driver_entry **driver);
 
+/** Register dynamically linked driver by name only, shared library is loaded on first activation.
+ */
+extern indigo_result indigo_register_driver(const char *name, const uint16_t *usb_vendors, indigo_driver_entry **driver);
+
+/** Load registered driver if not loaded yet and initialize it (already initialized driver is left intact).
+ */
+extern indigo_result indigo_activate_driver(indigo_driver_entry *driver);
+
+/** Activate not initialized drivers on arrival of USB device with matching vendor ID, callback is called after activation.
+ */
+extern void indigo_start_on_demand_activation(void (*callback)(indigo_driver_entry *driver));
+
 /** Create bonjour service name.
  */
 void indigo_service_name(const char *host, int port, char *name);
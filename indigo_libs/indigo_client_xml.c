@@ -34,17 +34,18 @@
 
 #include "indigo_xml.h"
 #include "indigo_io.h"
+#include "indigo_dtoa.h"
 #include "indigo_version.h"
 #include "indigo_client_xml.h"
 
-static pthread_mutex_t xml_mutex = PTHREAD_MUTEX_INITIALIZER;
-
 static indigo_result xml_client_parser_enumerate_properties(indigo_device *device, indigo_client *client, indigo_property *property) {
 	assert(device != NULL);
-	pthread_mutex_lock(&xml_mutex);
 	indigo_adapter_context *device_context = (indigo_adapter_context *)device->device_context;
 	assert(device_context != NULL);
-	int handle = device_context->output;
+	pthread_mutex_lock(&device_context->output_mutex);
+	indigo_output_buffer *buffer = device_context->output_buffer;
+	const char *raw_blobs = indigo_use_raw_blobs ? " blob='raw'" : "";
+	const char *compression = indigo_use_compression ? " compression='deflate'" : "";
 	char device_name[INDIGO_NAME_SIZE];
 	if (property != NULL && *property->device) {
 		strcpy(device_name, property->device);
@@ -57,30 +58,35 @@ static indigo_result xml_client_parser_enumerate_properties(indigo_device *devic
 			}
 		}
 	}
+	indigo_buffer_printf(buffer, "<getProperties version='1.7'%s%s switch='%d.%d'", raw_blobs, compression, (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF);
 	if (property != NULL) {
-		if (*property->device && *indigo_property_name(device->version, property)) {
-			indigo_printf(handle, "<getProperties version='1.7' switch='%d.%d' device='%s' name='%s'/>\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, indigo_xml_escape(device_name), indigo_property_name(device->version, property));
-		} else if (*property->device) {
-			indigo_printf(handle, "<getProperties version='1.7' switch='%d.%d' device='%s'/>\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, indigo_xml_escape(device_name));
-		} else if (*indigo_property_name(device->version, property)) {
-			indigo_printf(handle, "<getProperties version='1.7' switch='%d.%d' name='%s'/>\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, indigo_property_name(device->version, property));
-		} else {
-			indigo_printf(handle, "<getProperties version='1.7' switch='%d.%d'/>\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF);
+		if (*property->device) {
+			indigo_buffer_write(buffer, " device='", 9);
+			indigo_buffer_xml_escape(buffer, device_name);
+			indigo_buffer_write(buffer, "'", 1);
 		}
-	} else {
-		indigo_printf(handle, "<getProperties version='1.7' switch='%d.%d'/>\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF);
+		if (*indigo_property_name(device->version, property))
+			indigo_buffer_printf(buffer, " name='%s'", indigo_property_name(device->version, property));
 	}
-	pthread_mutex_unlock(&xml_mutex);
+	indigo_buffer_write(buffer, "/>\n", 3);
+	indigo_buffer_flush(buffer);
+	pthread_mutex_unlock(&device_context->output_mutex);
 	return INDIGO_OK;
 }
 
+static void write_change_start(indigo_output_buffer *buffer, const char *tag, indigo_device *device, indigo_property *property, const char *device_name) {
+	indigo_buffer_printf(buffer, "<%s device='", tag);
+	indigo_buffer_xml_escape(buffer, device_name);
+	indigo_buffer_printf(buffer, "' name='%s'>\n", indigo_property_name(device->version, property));
+}
+
 static indigo_result xml_client_parser_change_property(indigo_device *device, indigo_client *client, indigo_property *property) {
 	assert(device != NULL);
 	assert(property != NULL);
-	pthread_mutex_lock(&xml_mutex);
 	indigo_adapter_context *device_context = (indigo_adapter_context *)device->device_context;
 	assert(device_context != NULL);
-	int handle = device_context->output;
+	pthread_mutex_lock(&device_context->output_mutex);
+	indigo_output_buffer *buffer = device_context->output_buffer;
 	char device_name[INDIGO_NAME_SIZE];
 	strcpy(device_name, property->device);
 	if (indigo_use_host_suffix) {
@@ -93,39 +99,47 @@ static indigo_result xml_client_parser_change_property(indigo_device *device, in
 	}
 	switch (property->type) {
 	case INDIGO_TEXT_VECTOR:
-		indigo_printf(handle, "<newTextVector device='%s' name='%s'>\n", indigo_xml_escape(device_name), indigo_property_name(device->version, property), indigo_property_state_text[property->state]);
+		write_change_start(buffer, "newTextVector", device, property, device_name);
 		for (int i = 0; i < property->count; i++) {
 			indigo_item *item = &property->items[i];
-			indigo_printf(handle, "<oneText name='%s'>%s</oneText>\n", indigo_item_name(device->version, property, item), indigo_xml_escape(item->text.value));
+			indigo_buffer_printf(buffer, "<oneText name='%s'>", indigo_item_name(device->version, property, item));
+			indigo_buffer_xml_escape(buffer, item->text.value);
+			indigo_buffer_write(buffer, "</oneText>\n", 11);
 		}
-		indigo_printf(handle, "</newTextVector>\n");
+		indigo_buffer_printf(buffer, "</newTextVector>\n");
 		break;
 	case INDIGO_NUMBER_VECTOR:
-		indigo_printf(handle, "<newNumberVector device='%s' name='%s'>\n", indigo_xml_escape(device_name), indigo_property_name(device->version, property), indigo_property_state_text[property->state]);
+		write_change_start(buffer, "newNumberVector", device, property, device_name);
 		for (int i = 0; i < property->count; i++) {
 			indigo_item *item = &property->items[i];
-			indigo_printf(handle, "<oneNumber name='%s'>%g</oneNumber>\n", indigo_item_name(device->version, property, item), item->number.value);
+			char value[INDIGO_DTOA_SIZE];
+			indigo_dtoa(item->number.value, value);
+			indigo_buffer_printf(buffer, "<oneNumber name='%s'>%s</oneNumber>\n", indigo_item_name(device->version, property, item), value);
 		}
-		indigo_printf(handle, "</newNumberVector>\n");
+		indigo_buffer_printf(buffer, "</newNumberVector>\n");
 		break;
 	case INDIGO_SWITCH_VECTOR:
-		indigo_printf(handle, "<newSwitchVector device='%s' name='%s'>\n", indigo_xml_escape(device_name), indigo_property_name(device->version, property), indigo_property_state_text[property->state]);
+		write_change_start(buffer, "newSwitchVector", device, property, device_name);
 		for (int i = 0; i < property->count; i++) {
 			indigo_item *item = &property->items[i];
-			indigo_printf(handle, "<oneSwitch name='%s'>%s</oneSwitch>\n", indigo_item_name(device->version, property, item), item->sw.value ? "On" : "Off");
+			indigo_buffer_printf(buffer, "<oneSwitch name='%s'>%s</oneSwitch>\n", indigo_item_name(device->version, property, item), item->sw.value ? "On" : "Off");
 		}
-		indigo_printf(handle, "</newSwitchVector>\n");
+		indigo_buffer_printf(buffer, "</newSwitchVector>\n");
 		break;
 	default:
 		break;
 	}
-	pthread_mutex_unlock(&xml_mutex);
+	indigo_buffer_flush(buffer);
+	pthread_mutex_unlock(&device_context->output_mutex);
 	return INDIGO_OK;
 }
 
 static indigo_result xml_client_parser_detach(indigo_device *device) {
 	assert(device != NULL);
 	indigo_adapter_context *device_context = (indigo_adapter_context *)device->device_context;
+	pthread_mutex_lock(&device_context->output_mutex);
+	indigo_buffer_flush(device_context->output_buffer);
+	pthread_mutex_unlock(&device_context->output_mutex);
 	close(device_context->input);
 	close(device_context->output);
 	return INDIGO_OK;
@@ -147,6 +161,9 @@ indigo_device *indigo_xml_client_adapter(char *name, char *url_prefix, int input
 	assert(device_context != NULL);
 	device_context->input = input;
 	device_context->output = ouput;
+	device_context->raw_blobs = false;
+	device_context->output_buffer = indigo_create_output_buffer(ouput);
+	pthread_mutex_init(&device_context->output_mutex, NULL);
 	strncpy(device_context->url_prefix, url_prefix, INDIGO_NAME_SIZE);
 	device->device_context = device_context;
 	return device;
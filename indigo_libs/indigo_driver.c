@@ -66,6 +66,7 @@
 #include "indigo_xml.h"
 #include "indigo_names.h"
 #include "indigo_io.h"
+#include "indigo_dtoa.h"
 
 #if defined(INDIGO_LINUX)
 bool is_serial(char *path) {
@@ -339,6 +340,8 @@ indigo_result indigo_load_properties(indigo_device *device, bool default_propert
 		memset(client, 0, sizeof(indigo_client));
 		indigo_adapter_context *context = malloc(sizeof(indigo_adapter_context));
 		context->input = handle;
+		context->output_buffer = NULL;
+		context->raw_blobs = false;
 		client->client_context = context;
 		client->version = INDIGO_VERSION_CURRENT;
 		indigo_xml_parse(NULL, client);
@@ -349,6 +352,12 @@ indigo_result indigo_load_properties(indigo_device *device, bool default_propert
 	return handle > 0 ? INDIGO_OK : INDIGO_FAILED;
 }
 
+static void write_save_start(indigo_output_buffer *buffer, const char *tag, indigo_property *property) {
+	indigo_buffer_printf(buffer, "<%s device='", tag);
+	indigo_buffer_xml_escape(buffer, property->device);
+	indigo_buffer_printf(buffer, "' name='%s'>\n", property->name);
+}
+
 indigo_result indigo_save_property(indigo_device*device, int *file_handle, indigo_property *property) {
 	if (!property->hidden && property->perm != INDIGO_RO_PERM) {
 		if (file_handle == NULL)
@@ -359,34 +368,42 @@ indigo_result indigo_save_property(indigo_device*device, int *file_handle, indig
 			if (handle == 0)
 				return INDIGO_FAILED;
 		}
+		/* escaped values are streamed to the file, so saving is thread safe */
+		indigo_output_buffer *buffer = indigo_create_output_buffer(handle);
 		switch (property->type) {
 		case INDIGO_TEXT_VECTOR:
-			indigo_printf(handle, "<newTextVector device='%s' name='%s'>\n", indigo_xml_escape(property->device), property->name, indigo_property_state_text[property->state]);
+			write_save_start(buffer, "newTextVector", property);
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
-				indigo_printf(handle, "<oneText name='%s'>%s</oneText>\n", item->name, indigo_xml_escape(item->text.value));
+				indigo_buffer_printf(buffer, "<oneText name='%s'>", item->name);
+				indigo_buffer_xml_escape(buffer, item->text.value);
+				indigo_buffer_printf(buffer, "</oneText>\n");
 			}
-			indigo_printf(handle, "</newTextVector>\n");
+			indigo_buffer_printf(buffer, "</newTextVector>\n");
 			break;
 		case INDIGO_NUMBER_VECTOR:
-			indigo_printf(handle, "<newNumberVector device='%s' name='%s'>\n", indigo_xml_escape(property->device), property->name, indigo_property_state_text[property->state]);
+			write_save_start(buffer, "newNumberVector", property);
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
-				indigo_printf(handle, "<oneNumber name='%s'>%g</oneNumber>\n", item->name, item->number.value);
+				char value[INDIGO_DTOA_SIZE];
+				indigo_dtoa(item->number.value, value);
+				indigo_buffer_printf(buffer, "<oneNumber name='%s'>%s</oneNumber>\n", item->name, value);
 			}
-			indigo_printf(handle, "</newNumberVector>\n");
+			indigo_buffer_printf(buffer, "</newNumberVector>\n");
 			break;
 		case INDIGO_SWITCH_VECTOR:
-			indigo_printf(handle, "<newSwitchVector device='%s' name='%s'>\n", indigo_xml_escape(property->device), property->name, indigo_property_state_text[property->state]);
+			write_save_start(buffer, "newSwitchVector", property);
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
-				indigo_printf(handle, "<oneSwitch name='%s'>%s</oneSwitch>\n", item->name, item->sw.value ? "On" : "Off");
+				indigo_buffer_printf(buffer, "<oneSwitch name='%s'>%s</oneSwitch>\n", item->name, item->sw.value ? "On" : "Off");
 			}
-			indigo_printf(handle, "</newSwitchVector>\n");
+			indigo_buffer_printf(buffer, "</newSwitchVector>\n");
 			break;
 		default:
 			break;
 		}
+		indigo_buffer_flush(buffer);
+		indigo_release_output_buffer(buffer);
 	}
 	return INDIGO_OK;
 }
@@ -420,16 +437,16 @@ double indigo_stod(char *string) {
 	double value = 0;
 	char *separator = strpbrk(string, ":*' ");
 	if (separator == NULL) {
-		value = atof(string);
+		value = indigo_atof(string);
 	} else {
 		*separator++ = 0;
-		value = atof(string);
+		value = indigo_atof(string);
 		separator = strpbrk(string = separator, ":*' ");
 		if (separator == NULL) {
-			value += atof(string)/60.0;
+			value += indigo_atof(string)/60.0;
 		} else {
 			*separator++ = 0;
-			value += atof(string)/60.0 + atof(separator)/3600.0;
+			value += indigo_atof(string)/60.0 + indigo_atof(separator)/3600.0;
 		}
 	}
 	return value;
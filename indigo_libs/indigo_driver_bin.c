@@ -0,0 +1,383 @@
+// Copyright (c) 2016 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 Build 0 - PoC by Peter Polakovic <peter.polakovic@cloudmakers.eu>
+
+/** INDIGO binary wire protocol client side adapter
+ \file indigo_driver_bin.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <assert.h>
+#include <stdint.h>
+
+#include "indigo_driver_bin.h"
+#include "indigo_io.h"
+
+//#undef INDIGO_TRACE_PROTOCOL
+//#define INDIGO_TRACE_PROTOCOL(c) c
+
+#define NAME_INDEX_SIZE	(2 * INDIGO_BIN_MAX_NAMES)
+
+/* adapter context extended with table of names interned by server */
+
+typedef struct {
+	indigo_adapter_context context;
+	int name_count;
+	char (*names)[INDIGO_NAME_SIZE];
+	uint16_t *name_index;               /* open addressing hash table, 0 is empty slot, otherwise name reference */
+} bin_adapter_context;
+
+static void write_byte(indigo_output_buffer *buffer, uint8_t value) {
+	*indigo_buffer_reserve(buffer, 1) = value;
+	buffer->length++;
+}
+
+static void write_varint(indigo_output_buffer *buffer, uint64_t value) {
+	uint8_t *pnt = (uint8_t *)indigo_buffer_reserve(buffer, 10);
+	int length = 0;
+	while (value >= 0x80) {
+		pnt[length++] = (value & 0x7F) | 0x80;
+		value >>= 7;
+	}
+	pnt[length++] = value;
+	buffer->length += length;
+}
+
+static void write_string(indigo_output_buffer *buffer, const char *string) {
+	long length = strlen(string);
+	write_varint(buffer, length);
+	indigo_buffer_write(buffer, string, length);
+}
+
+static void write_name(bin_adapter_context *client_context, const char *name) {
+	indigo_output_buffer *buffer = client_context->context.output_buffer;
+	/* longer names are truncated to fit to name table of the peer */
+	int length = (int)strnlen(name, INDIGO_NAME_SIZE - 1);
+	uint32_t hash = 2166136261u;
+	for (int i = 0; i < length; i++)
+		hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+	uint32_t slot = hash & (NAME_INDEX_SIZE - 1);
+	int reference;
+	while ((reference = client_context->name_index[slot])) {
+		const char *interned = client_context->names[reference - 1];
+		if (!strncmp(interned, name, length) && interned[length] == 0) {
+			write_varint(buffer, reference);
+			return;
+		}
+		slot = (slot + 1) & (NAME_INDEX_SIZE - 1);
+	}
+	if (client_context->name_count < INDIGO_BIN_MAX_NAMES) {
+		char *interned = client_context->names[client_context->name_count++];
+		memcpy(interned, name, length);
+		interned[length] = 0;
+		client_context->name_index[slot] = client_context->name_count;
+	}
+	write_varint(buffer, 0);
+	write_varint(buffer, length);
+	indigo_buffer_write(buffer, name, length);
+}
+
+static void write_double(indigo_output_buffer *buffer, double value) {
+	uint64_t bits;
+	memcpy(&bits, &value, 8);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	bits = __builtin_bswap64(bits);
+#endif
+	memcpy(indigo_buffer_reserve(buffer, 8), &bits, 8);
+	buffer->length += 8;
+}
+
+static void write_array_values(indigo_output_buffer *buffer, indigo_item *item) {
+	long count = item->array.value ? item->array.count : 0;
+	int element_size = item->array.type == INDIGO_ARRAY_DOUBLE ? 8 : 4;
+	write_varint(buffer, count);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	for (long i = 0; i < count; i++) {
+		char *element = (char *)item->array.value + i * element_size;
+		char *pnt = indigo_buffer_reserve(buffer, element_size);
+		for (int j = 0; j < element_size; j++)
+			pnt[j] = element[element_size - 1 - j];
+		buffer->length += element_size;
+	}
+#else
+	indigo_buffer_write(buffer, item->array.value, count * element_size);
+#endif
+}
+
+static void write_message(indigo_output_buffer *buffer, const char *message, bool delta) {
+	write_byte(buffer, (message ? INDIGO_BIN_FLAG_MESSAGE : 0) | (delta ? INDIGO_BIN_FLAG_DELTA : 0));
+	if (message)
+		write_string(buffer, message);
+}
+
+static indigo_result define_property(indigo_client *client, struct indigo_device *device, indigo_property *property, const char *message, bool delta) {
+	assert(device != NULL);
+	assert(client != NULL);
+	assert(property != NULL);
+	if (client->version == INDIGO_VERSION_NONE)
+		return INDIGO_OK;
+	indigo_property *shared = property;
+	property = indigo_acquire_property_snapshot(shared);
+	bin_adapter_context *client_context = (bin_adapter_context *)client->client_context;
+	assert(client_context != NULL);
+	pthread_mutex_lock(&client_context->context.output_mutex);
+	indigo_output_buffer *buffer = client_context->context.output_buffer;
+	write_byte(buffer, INDIGO_BIN_DEF_VECTOR);
+	write_byte(buffer, property->type);
+	write_name(client_context, property->device);
+	write_name(client_context, property->name);
+	write_name(client_context, property->group);
+	write_string(buffer, property->label);
+	write_byte(buffer, property->perm);
+	write_byte(buffer, property->state);
+	write_byte(buffer, property->rule);
+	write_message(buffer, message, delta);
+	write_varint(buffer, property->count);
+	for (int i = 0; i < property->count; i++) {
+		indigo_item *item = &property->items[i];
+		write_name(client_context, item->name);
+		write_string(buffer, item->label);
+		switch (property->type) {
+			case INDIGO_TEXT_VECTOR:
+				write_string(buffer, item->text.value);
+				break;
+			case INDIGO_NUMBER_VECTOR:
+				write_name(client_context, item->number.format);
+				write_double(buffer, item->number.min);
+				write_double(buffer, item->number.max);
+				write_double(buffer, item->number.step);
+				write_double(buffer, item->number.target);
+				write_double(buffer, item->number.value);
+				break;
+			case INDIGO_SWITCH_VECTOR:
+				write_byte(buffer, item->sw.value);
+				break;
+			case INDIGO_LIGHT_VECTOR:
+				write_byte(buffer, item->light.value);
+				break;
+			case INDIGO_BLOB_VECTOR:
+				break;
+			case INDIGO_ARRAY_VECTOR:
+				write_byte(buffer, item->array.type);
+				break;
+		}
+	}
+	indigo_buffer_flush(buffer);
+	INDIGO_TRACE_PROTOCOL(indigo_trace("sent: defVector '%s' '%s'", property->device, property->name));
+	indigo_release_property_snapshot(shared, property);
+	pthread_mutex_unlock(&client_context->context.output_mutex);
+	return INDIGO_OK;
+}
+
+static indigo_result bin_define_property(indigo_client *client, struct indigo_device *device, indigo_property *property, const char *message) {
+	return define_property(client, device, property, message, false);
+}
+
+static indigo_result bin_update_property(indigo_client *client, struct indigo_device *device, indigo_property *property, const char *message) {
+	assert(device != NULL);
+	assert(client != NULL);
+	assert(property != NULL);
+	if (client->version == INDIGO_VERSION_NONE)
+		return INDIGO_OK;
+	if (property->type == INDIGO_BLOB_VECTOR ? client->enable_blob == INDIGO_ENABLE_BLOB_NEVER : client->enable_blob == INDIGO_ENABLE_BLOB_ONLY)
+		return INDIGO_OK;
+	indigo_property *shared = property;
+	property = indigo_acquire_property_snapshot(shared);
+	bin_adapter_context *client_context = (bin_adapter_context *)client->client_context;
+	assert(client_context != NULL);
+	pthread_mutex_lock(&client_context->context.output_mutex);
+	indigo_output_buffer *buffer = client_context->context.output_buffer;
+	write_byte(buffer, INDIGO_BIN_SET_VECTOR);
+	write_byte(buffer, property->type);
+	write_name(client_context, property->device);
+	write_name(client_context, property->name);
+	write_byte(buffer, property->state);
+	write_message(buffer, message, false);
+	write_varint(buffer, property->count);
+	for (int i = 0; i < property->count; i++) {
+		indigo_item *item = &property->items[i];
+		write_name(client_context, item->name);
+		switch (property->type) {
+			case INDIGO_TEXT_VECTOR:
+				write_string(buffer, item->text.value);
+				break;
+			case INDIGO_NUMBER_VECTOR:
+				write_double(buffer, item->number.target);
+				write_double(buffer, item->number.value);
+				break;
+			case INDIGO_SWITCH_VECTOR:
+				write_byte(buffer, item->sw.value);
+				break;
+			case INDIGO_LIGHT_VECTOR:
+				write_byte(buffer, item->light.value);
+				break;
+			case INDIGO_BLOB_VECTOR:
+				if (property->state != INDIGO_OK_STATE || item->blob.value == NULL) {
+					write_byte(buffer, INDIGO_BIN_BLOB_NONE);
+				} else if (client->enable_blob == INDIGO_ENABLE_BLOB_URL) {
+					char url[INDIGO_VALUE_SIZE];
+					snprintf(url, sizeof(url), "/blob/%p%s", item, item->blob.format);
+					write_byte(buffer, INDIGO_BIN_BLOB_URL);
+					write_name(client_context, item->blob.format);
+					write_string(buffer, url);
+				} else {
+					/* large payload is written directly together with pending output */
+					write_byte(buffer, INDIGO_BIN_BLOB_RAW);
+					write_name(client_context, item->blob.format);
+					write_varint(buffer, item->blob.size);
+					indigo_buffer_write(buffer, item->blob.value, item->blob.size);
+				}
+				break;
+			case INDIGO_ARRAY_VECTOR:
+				write_byte(buffer, item->array.type);
+				write_varint(buffer, item->array.rank);
+				for (int j = 0; j < item->array.rank; j++)
+					write_varint(buffer, item->array.shape[j]);
+				write_array_values(buffer, item);
+				break;
+		}
+	}
+	indigo_buffer_flush(buffer);
+	INDIGO_TRACE_PROTOCOL(indigo_trace("sent: setVector '%s' '%s'", property->device, property->name));
+	indigo_release_property_snapshot(shared, property);
+	pthread_mutex_unlock(&client_context->context.output_mutex);
+	return INDIGO_OK;
+}
+
+static indigo_result bin_delete_property(indigo_client *client, struct indigo_device *device, indigo_property *property, const char *message) {
+	assert(device != NULL);
+	assert(client != NULL);
+	assert(property != NULL);
+	if (client->version == INDIGO_VERSION_NONE)
+		return INDIGO_OK;
+	bin_adapter_context *client_context = (bin_adapter_context *)client->client_context;
+	assert(client_context != NULL);
+	pthread_mutex_lock(&client_context->context.output_mutex);
+	indigo_output_buffer *buffer = client_context->context.output_buffer;
+	write_byte(buffer, INDIGO_BIN_DELETE_PROPERTY);
+	write_name(client_context, *property->name ? property->device : device->name);
+	write_name(client_context, property->name);
+	write_message(buffer, message, false);
+	indigo_buffer_flush(buffer);
+	INDIGO_TRACE_PROTOCOL(indigo_trace("sent: deleteProperty '%s' '%s'", property->device, property->name));
+	pthread_mutex_unlock(&client_context->context.output_mutex);
+	return INDIGO_OK;
+}
+
+static indigo_result bin_define_property_items(indigo_client *client, struct indigo_device *device, indigo_property *property, indigo_property *items, const char *message) {
+	return define_property(client, device, items, message, true);
+}
+
+static indigo_result bin_delete_property_items(indigo_client *client, struct indigo_device *device, indigo_property *property, indigo_property *items, const char *message) {
+	assert(device != NULL);
+	assert(client != NULL);
+	assert(items != NULL);
+	if (client->version == INDIGO_VERSION_NONE)
+		return INDIGO_OK;
+	bin_adapter_context *client_context = (bin_adapter_context *)client->client_context;
+	assert(client_context != NULL);
+	pthread_mutex_lock(&client_context->context.output_mutex);
+	indigo_output_buffer *buffer = client_context->context.output_buffer;
+	write_byte(buffer, INDIGO_BIN_DELETE_ITEMS);
+	write_name(client_context, items->device);
+	write_name(client_context, items->name);
+	write_message(buffer, message, false);
+	write_varint(buffer, items->count);
+	for (int i = 0; i < items->count; i++)
+		write_name(client_context, items->items[i].name);
+	indigo_buffer_flush(buffer);
+	INDIGO_TRACE_PROTOCOL(indigo_trace("sent: deleteItems '%s' '%s'", items->device, items->name));
+	pthread_mutex_unlock(&client_context->context.output_mutex);
+	return INDIGO_OK;
+}
+
+static indigo_result bin_message_property(indigo_client *client, struct indigo_device *device, const char *message) {
+	assert(device != NULL);
+	assert(client != NULL);
+	if (client->version == INDIGO_VERSION_NONE)
+		return INDIGO_OK;
+	bin_adapter_context *client_context = (bin_adapter_context *)client->client_context;
+	assert(client_context != NULL);
+	pthread_mutex_lock(&client_context->context.output_mutex);
+	indigo_output_buffer *buffer = client_context->context.output_buffer;
+	write_byte(buffer, INDIGO_BIN_MESSAGE);
+	write_name(client_context, device->name);
+	// empty message relayed from chained server is broadcasted as NULL
+	write_string(buffer, message ? message : "");
+	indigo_buffer_flush(buffer);
+	INDIGO_TRACE_PROTOCOL(indigo_trace("sent: message '%s'", message));
+	pthread_mutex_unlock(&client_context->context.output_mutex);
+	return INDIGO_OK;
+}
+
+static indigo_result bin_detach(indigo_client *client) {
+	assert(client != NULL);
+	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
+	close(client_context->input);
+	close(client_context->output);
+	return INDIGO_OK;
+}
+
+indigo_client *indigo_bin_device_adapter(int input, int ouput) {
+	static indigo_client client_template = {
+		"", NULL, INDIGO_OK, INDIGO_VERSION_NONE, INDIGO_ENABLE_BLOB_ALSO,
+		NULL,
+		bin_define_property,
+		bin_update_property,
+		bin_delete_property,
+		bin_message_property,
+		bin_detach,
+		bin_define_property_items,
+		bin_delete_property_items
+	};
+	indigo_client *client = malloc(sizeof(indigo_client));
+	assert(client != NULL);
+	memcpy(client, &client_template, sizeof(indigo_client));
+	bin_adapter_context *client_context = malloc(sizeof(bin_adapter_context));
+	assert(client_context != NULL);
+	memset(client_context, 0, sizeof(bin_adapter_context));
+	client_context->context.input = input;
+	client_context->context.output = ouput;
+	client_context->context.output_buffer = indigo_create_output_buffer(ouput);
+	pthread_mutex_init(&client_context->context.output_mutex, NULL);
+	client_context->names = malloc(INDIGO_BIN_MAX_NAMES * INDIGO_NAME_SIZE);
+	assert(client_context->names != NULL);
+	client_context->name_index = malloc(NAME_INDEX_SIZE * sizeof(uint16_t));
+	assert(client_context->name_index != NULL);
+	memset(client_context->name_index, 0, NAME_INDEX_SIZE * sizeof(uint16_t));
+	client->client_context = client_context;
+	return client;
+}
+
+void indigo_release_bin_device_adapter(indigo_client *client) {
+	assert(client != NULL);
+	bin_adapter_context *client_context = (bin_adapter_context *)client->client_context;
+	assert(client_context != NULL);
+	indigo_release_output_buffer(client_context->context.output_buffer);
+	pthread_mutex_destroy(&client_context->context.output_mutex);
+	free(client_context->names);
+	free(client_context->name_index);
+	free(client_context);
+	free(client);
+}
@@ -37,14 +37,20 @@
 
 #include "indigo_json.h"
 #include "indigo_io.h"
+#include "indigo_dtoa.h"
+
+/* key of output shared by all JSON clients during update broadcast */
+#define JSON_OUTPUT_KEY	('J' << 24)
 
 //#undef INDIGO_TRACE_PROTOCOL
 //#define INDIGO_TRACE_PROTOCOL(c) c
 
-static pthread_mutex_t json_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define WS_TEXT_FRAME		0x81
+#define WS_BINARY_FRAME	0x82
+#define WS_COMPRESSED_TEXT_FRAME	0xC1
 
-static void ws_write(int handle, const char *buffer, long length) {
-	uint8_t header[10] = { 0x81 };
+static void ws_write_header(int handle, uint8_t opcode, long length) {
+	uint8_t header[10] = { opcode };
 	if (length <= 0x7D) {
 		header[1] = length;
 		indigo_write(handle, (char *)header, 2);
@@ -59,243 +65,328 @@ static void ws_write(int handle, const char *buffer, long length) {
 		memcpy(header+2, &payloadLength, 8);
 		indigo_write(handle, (char *)header, 10);
 	}
-	indigo_write(handle, buffer, length);
 }
 
-static indigo_result json_define_property(indigo_client *client, struct indigo_device *device, indigo_property *property, const char *message) {
+static void ws_write(indigo_adapter_context *client_context, const char *buffer, long length) {
+	if (client_context->compression) {
+		length = indigo_ws_compress(client_context->compression, buffer, length, &buffer);
+		ws_write_header(client_context->output, WS_COMPRESSED_TEXT_FRAME, length);
+	} else {
+		ws_write_header(client_context->output, WS_TEXT_FRAME, length);
+	}
+	indigo_write(client_context->output, buffer, length);
+}
+
+#define write_literal(buffer, text) indigo_buffer_write(buffer, text, sizeof(text) - 1)
+
+/* string values are escaped as they are appended, prefix is written verbatim */
+
+static void write_string(indigo_output_buffer *buffer, const char *prefix, const char *string) {
+	indigo_buffer_write(buffer, prefix, strlen(prefix));
+	write_literal(buffer, "\"");
+	indigo_buffer_json_escape(buffer, string);
+	write_literal(buffer, "\"");
+}
+
+/* numbers are formatted without printf (shortest round-trip representation, '.' regardless of locale) */
+
+static void write_number(indigo_output_buffer *buffer, const char *prefix, double value) {
+	long prefix_length = strlen(prefix);
+	char *pnt = indigo_buffer_reserve(buffer, prefix_length + INDIGO_DTOA_SIZE);
+	memcpy(pnt, prefix, prefix_length);
+	buffer->length += prefix_length + indigo_dtoa(value, pnt + prefix_length);
+}
+
+static void write_definition_start(indigo_output_buffer *buffer, const char *tag, indigo_property *property) {
+	indigo_buffer_printf(buffer, "{ \"%s\": { \"version\": %d", tag, property->version);
+	write_string(buffer, ", \"device\": ", property->device);
+	write_string(buffer, ", \"name\": ", property->name);
+	write_string(buffer, ", \"group\": ", property->group);
+	write_string(buffer, ", \"label\": ", property->label);
+}
+
+static void write_update_start(indigo_output_buffer *buffer, const char *tag, indigo_property *property) {
+	indigo_buffer_printf(buffer, "{ \"%s\": { ", tag);
+	write_string(buffer, "\"device\": ", property->device);
+	write_string(buffer, ", \"name\": ", property->name);
+	indigo_buffer_printf(buffer, ", \"state\": \"%s\"", indigo_property_state_text[property->state]);
+}
+
+static void write_items_start(indigo_output_buffer *buffer, bool delta, const char *message) {
+	if (delta)
+		write_literal(buffer, ", \"delta\": true");
+	if (message)
+		write_string(buffer, ", \"message\": ", message);
+	write_literal(buffer, ", \"items\": [ ");
+}
+
+static void write_item_start(indigo_output_buffer *buffer, int index, indigo_item *item) {
+	write_string(buffer, index > 0 ? ", { \"name\": " : " { \"name\": ", item->name);
+}
+
+static void send_message(indigo_adapter_context *client_context, const char *data, long length) {
+	if (client_context->web_socket)
+		ws_write(client_context, data, length);
+	else
+		indigo_write(client_context->output, data, length);
+	INDIGO_TRACE_PROTOCOL(indigo_trace("sent: %.*s\n", (int)length, data));
+}
+
+/* BLOB item is sent as binary frame, raw data are preceded by single line JSON tag identifying property and item */
+
+static void ws_write_blob(indigo_adapter_context *client_context, indigo_property *property, indigo_item *item) {
+	indigo_output_buffer *buffer = client_context->output_buffer;
+	buffer->length = 0;
+	write_string(buffer, "{ \"device\": ", property->device);
+	write_string(buffer, ", \"name\": ", property->name);
+	write_string(buffer, ", \"item\": ", item->name);
+	write_string(buffer, ", \"format\": ", item->blob.format);
+	indigo_buffer_printf(buffer, ", \"size\": %ld }\n", item->blob.size);
+	ws_write_header(client_context->output, WS_BINARY_FRAME, buffer->length + item->blob.size);
+	indigo_write(client_context->output, buffer->data, buffer->length);
+	indigo_write(client_context->output, item->blob.value, item->blob.size);
+}
+
+static indigo_result define_property(indigo_client *client, struct indigo_device *device, indigo_property *property, const char *message, bool delta) {
 	assert(device != NULL);
 	assert(client != NULL);
 	assert(property != NULL);
 	if (client->version == INDIGO_VERSION_NONE)
 		return INDIGO_OK;
-	pthread_mutex_lock(&json_mutex);
+	indigo_property *shared = property;
+	property = indigo_acquire_property_snapshot(shared);
 	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
 	assert(client_context != NULL);
-	int handle = client_context->output;
-	char output_buffer[JSON_BUFFER_SIZE];
-	char *pnt = output_buffer;
-	int size;
+	pthread_mutex_lock(&client_context->output_mutex);
+	indigo_output_buffer *buffer = client_context->output_buffer;
+	buffer->length = 0;
 	switch (property->type) {
 		case INDIGO_TEXT_VECTOR:
-			size = sprintf(pnt, "{ \"defTextVector\": { \"version\": %d, \"device\": \"%s\", \"name\": \"%s\", \"group\": \"%s\", \"label\": \"%s\", \"perm\": \"%s\", \"state\": \"%s\"", property->version, property->device, property->name, property->group, property->label, indigo_property_perm_text[property->perm], indigo_property_state_text[property->state]);
-			pnt += size;
-			if (message) {
-				size = sprintf(pnt, ", \"message\": \"%s\", \"items\": [ ", message);
-				pnt += size;
-			} else {
-				size = sprintf(pnt, ", \"items\": [ ");
-				pnt += size;
-			}
+			write_definition_start(buffer, "defTextVector", property);
+			indigo_buffer_printf(buffer, ", \"perm\": \"%s\", \"state\": \"%s\"", indigo_property_perm_text[property->perm], indigo_property_state_text[property->state]);
+			write_items_start(buffer, delta, message);
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
-				size = sprintf(pnt, "%s { \"name\": \"%s\", \"label\": \"%s\", \"value\": \"%s\" }",  i > 0 ? "," : "", item->name, item->label, item->text.value);
-				pnt += size;
+				write_item_start(buffer, i, item);
+				write_string(buffer, ", \"label\": ", item->label);
+				write_string(buffer, ", \"value\": ", item->text.value);
+				write_literal(buffer, " }");
 			}
-			size = sprintf(pnt, " ] } }");
-			size += pnt - output_buffer;
 			break;
 		case INDIGO_NUMBER_VECTOR:
-			size = sprintf(pnt, "{ \"defNumberVector\": { \"version\": %d, \"device\": \"%s\", \"name\": \"%s\", \"group\": \"%s\", \"label\": \"%s\", \"perm\": \"%s\", \"state\": \"%s\"", property->version, property->device, property->name, property->group, property->label, indigo_property_perm_text[property->perm], indigo_property_state_text[property->state]);
-			pnt += size;
-			if (message) {
-				size = sprintf(pnt, ", \"message\": \"%s\", \"items\": [ ", message);
-				pnt += size;
-			} else {
-				size = sprintf(pnt, ", \"items\": [ ");
-				pnt += size;
-			}
+			write_definition_start(buffer, "defNumberVector", property);
+			indigo_buffer_printf(buffer, ", \"perm\": \"%s\", \"state\": \"%s\"", indigo_property_perm_text[property->perm], indigo_property_state_text[property->state]);
+			write_items_start(buffer, delta, message);
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
+				write_item_start(buffer, i, item);
+				write_string(buffer, ", \"label\": ", item->label);
+				write_number(buffer, ", \"min\": ", item->number.min);
+				write_number(buffer, ", \"max\": ", item->number.max);
+				write_number(buffer, ", \"step\": ", item->number.step);
+				write_string(buffer, ", \"format\": ", item->number.format);
 				if (property->perm != INDIGO_RO_PERM)
-					size = sprintf(pnt, "%s { \"name\": \"%s\", \"label\": \"%s\", \"min\": %g, \"max\": %g, \"step\": %g, \"format\": \"%s\", \"target\": %g, \"value\": %g }",  i > 0 ? "," : "", item->name, item->label, item->number.min, item->number.max, item->number.step, item->number.format, item->number.target, item->number.value);
-				else
-					size = sprintf(pnt, "%s { \"name\": \"%s\", \"label\": \"%s\", \"min\": %g, \"max\": %g, \"step\": %g, \"format\": \"%s\", \"value\": %g }",  i > 0 ? "," : "", item->name, item->label, item->number.min, item->number.max, item->number.step, item->number.format, item->number.value);
-				pnt += size;
+					write_number(buffer, ", \"target\": ", item->number.target);
+				write_number(buffer, ", \"value\": ", item->number.value);
+				write_literal(buffer, " }");
 			}
-			size = sprintf(pnt, " ] } }");
-			size += pnt - output_buffer;
 			break;
 		case INDIGO_SWITCH_VECTOR:
-			size = sprintf(pnt, "{ \"defSwitchVector\": { \"version\": %d, \"device\": \"%s\", \"name\": \"%s\", \"group\": \"%s\", \"label\": \"%s\", \"perm\": \"%s\", \"state\": \"%s\", \"rule\": \"%s\"", property->version, property->device, property->name, property->group, property->label, indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], indigo_switch_rule_text[property->rule]);
-			pnt += size;
-			if (message) {
-				size = sprintf(pnt, ", \"message\": \"%s\", \"items\": [ ", message);
-				pnt += size;
-			} else {
-				size = sprintf(pnt, ", \"items\": [ ");
-				pnt += size;
-			}
+			write_definition_start(buffer, "defSwitchVector", property);
+			indigo_buffer_printf(buffer, ", \"perm\": \"%s\", \"state\": \"%s\", \"rule\": \"%s\"", indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], indigo_switch_rule_text[property->rule]);
+			write_items_start(buffer, delta, message);
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
-				size = sprintf(pnt, "%s { \"name\": \"%s\", \"label\": \"%s\", \"value\": %s }",  i > 0 ? "," : "", item->name, item->label, item->sw.value ? "true" : "false");
-				pnt += size;
+				write_item_start(buffer, i, item);
+				write_string(buffer, ", \"label\": ", item->label);
+				if (item->sw.value)
+					write_literal(buffer, ", \"value\": true }");
+				else
+					write_literal(buffer, ", \"value\": false }");
 			}
-			size = sprintf(pnt, " ] } }");
-			size += pnt - output_buffer;
 			break;
 		case INDIGO_LIGHT_VECTOR:
-			size = sprintf(pnt, "{ \"defLightVector\": { \"version\": %d, \"device\": \"%s\", \"name\": \"%s\", \"group\": \"%s\", \"label\": \"%s\", \"state\": \"%s\"", property->version, property->device, property->name, property->group, property->label, indigo_property_state_text[property->state]);
-			pnt += size;
-			if (message) {
-				size = sprintf(pnt, ", \"message\": \"%s\", \"items\": [ ", message);
-				pnt += size;
-			} else {
-				size = sprintf(pnt, ", \"items\": [ ");
-				pnt += size;
-			}
+			write_definition_start(buffer, "defLightVector", property);
+			indigo_buffer_printf(buffer, ", \"state\": \"%s\"", indigo_property_state_text[property->state]);
+			write_items_start(buffer, delta, message);
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
-				size = sprintf(pnt, "%s { \"name\": \"%s\", \"label\": \"%s\", \"value\": \"%s\" }",  i > 0 ? "," : "", item->name, item->label, indigo_property_state_text[item->light.value]);
-				pnt += size;
+				write_item_start(buffer, i, item);
+				write_string(buffer, ", \"label\": ", item->label);
+				indigo_buffer_printf(buffer, ", \"value\": \"%s\" }", indigo_property_state_text[item->light.value]);
 			}
-			size = sprintf(pnt, " ] } }");
-			size += pnt - output_buffer;
 			break;
 		case INDIGO_BLOB_VECTOR:
-			size = sprintf(pnt, "{ \"defBLOBVector\": { \"version\": %d, \"device\": \"%s\", \"name\": \"%s\", \"group\": \"%s\", \"label\": \"%s\", \"state\": \"%s\"", property->version, property->device, property->name, property->group, property->label, indigo_property_state_text[property->state]);
-			pnt += size;
-			if (message) {
-				size = sprintf(pnt, ", \"message\": \"%s\", \"items\": [ ", message);
-				pnt += size;
-			} else {
-				size = sprintf(pnt, ", \"items\": [ ");
-				pnt += size;
+			write_definition_start(buffer, "defBLOBVector", property);
+			indigo_buffer_printf(buffer, ", \"state\": \"%s\"", indigo_property_state_text[property->state]);
+			write_items_start(buffer, delta, message);
+			for (int i = 0; i < property->count; i++) {
+				indigo_item *item = &property->items[i];
+				write_item_start(buffer, i, item);
+				write_string(buffer, ", \"label\": ", item->label);
+				write_literal(buffer, " }");
 			}
+			break;
+		case INDIGO_ARRAY_VECTOR:
+			write_definition_start(buffer, "defArrayVector", property);
+			indigo_buffer_printf(buffer, ", \"state\": \"%s\"", indigo_property_state_text[property->state]);
+			write_items_start(buffer, delta, message);
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
-				size = sprintf(pnt, "%s { \"name\": \"%s\", \"label\": \"%s\" }", i > 0 ? "," : "", item->name, item->label);
-				pnt += size;
+				write_item_start(buffer, i, item);
+				write_string(buffer, ", \"label\": ", item->label);
+				indigo_buffer_printf(buffer, ", \"type\": \"%s\" }", indigo_array_type_text[item->array.type]);
 			}
-			size = sprintf(pnt, " ] } }");
-			size += pnt - output_buffer;
 			break;
 	}
-	if (client_context->web_socket)
-		ws_write(handle, output_buffer, size);
-	else
-		indigo_write(handle, output_buffer, size);
-	INDIGO_TRACE_PROTOCOL(indigo_trace("sent: %s\n", output_buffer));
-	pthread_mutex_unlock(&json_mutex);
+	write_literal(buffer, " ] } }");
+	send_message(client_context, buffer->data, buffer->length);
+	indigo_release_property_snapshot(shared, property);
+	pthread_mutex_unlock(&client_context->output_mutex);
 	return INDIGO_OK;
 }
 
-static indigo_result json_update_property(indigo_client *client, struct indigo_device *device, indigo_property *property, const char *message) {
-	assert(device != NULL);
-	assert(client != NULL);
-	assert(property != NULL);
-	if (client->version == INDIGO_VERSION_NONE)
-		return INDIGO_OK;
-	pthread_mutex_lock(&json_mutex);
-	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
-	assert(client_context != NULL);
-	int handle = client_context->output;
-	char output_buffer[JSON_BUFFER_SIZE];
-	char *pnt = output_buffer;
-	int size;
+static indigo_result json_define_property(indigo_client *client, struct indigo_device *device, indigo_property *property, const char *message) {
+	return define_property(client, device, property, message, false);
+}
+
+static void write_array_values(indigo_output_buffer *buffer, indigo_item *item) {
+	long count = item->array.value ? item->array.count : 0;
+	for (long j = 0; j < count; j++) {
+		/* separator and up to INDIGO_DTOA_SIZE characters per element */
+		char *pnt = indigo_buffer_reserve(buffer, INDIGO_DTOA_SIZE + 1);
+		if (j > 0) {
+			*pnt++ = ',';
+			buffer->length++;
+		}
+		switch (item->array.type) {
+			case INDIGO_ARRAY_DOUBLE:
+				buffer->length += indigo_dtoa(((double *)item->array.value)[j], pnt);
+				break;
+			case INDIGO_ARRAY_FLOAT:
+				buffer->length += indigo_ftoa(((float *)item->array.value)[j], pnt);
+				break;
+			case INDIGO_ARRAY_INT32:
+				buffer->length += sprintf(pnt, "%d", ((int32_t *)item->array.value)[j]);
+				break;
+		}
+	}
+}
+
+static void write_update(indigo_output_buffer *buffer, indigo_property *property, const char *message) {
 	switch (property->type) {
 		case INDIGO_TEXT_VECTOR:
-			size = sprintf(pnt, "{ \"setTextVector\": { \"device\": \"%s\", \"name\": \"%s\", \"state\": \"%s\"", property->device, property->name, indigo_property_state_text[property->state]);
-			pnt += size;
-			if (message) {
-				size = sprintf(pnt, ", \"message\": \"%s\", \"items\": [ ", message);
-				pnt += size;
-			} else {
-				size = sprintf(pnt, ", \"items\": [ ");
-				pnt += size;
-			}
+			write_update_start(buffer, "setTextVector", property);
+			write_items_start(buffer, false, message);
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
-				size = sprintf(pnt, "%s { \"name\": \"%s\", \"value\": \"%s\" }",  i > 0 ? "," : "", item->name, item->text.value);
-				pnt += size;
+				write_item_start(buffer, i, item);
+				write_string(buffer, ", \"value\": ", item->text.value);
+				write_literal(buffer, " }");
 			}
-			size = sprintf(pnt, " ] } }");
-			size += pnt - output_buffer;
 			break;
 		case INDIGO_NUMBER_VECTOR:
-			size = sprintf(pnt, "{ \"setNumberVector\": { \"device\": \"%s\", \"name\": \"%s\", \"state\": \"%s\"", property->device, property->name, indigo_property_state_text[property->state]);
-			pnt += size;
-			if (message) {
-				size = sprintf(pnt, ", \"message\": \"%s\", \"items\": [ ", message);
-				pnt += size;
-			} else {
-				size = sprintf(pnt, ", \"items\": [ ");
-				pnt += size;
-			}
+			write_update_start(buffer, "setNumberVector", property);
+			write_items_start(buffer, false, message);
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
+				write_item_start(buffer, i, item);
 				if (property->perm != INDIGO_RO_PERM)
-					size = sprintf(pnt, "%s { \"name\": \"%s\", \"target\": %g, \"value\": %g }",  i > 0 ? "," : "", item->name, item->number.target, item->number.value);
-				else
-					size = sprintf(pnt, "%s { \"name\": \"%s\", \"value\": %g }",  i > 0 ? "," : "", item->name, item->number.value);
-				pnt += size;
+					write_number(buffer, ", \"target\": ", item->number.target);
+				write_number(buffer, ", \"value\": ", item->number.value);
+				write_literal(buffer, " }");
 			}
-			size = sprintf(pnt, " ] } }");
-			size += pnt - output_buffer;
 			break;
 		case INDIGO_SWITCH_VECTOR:
-			size = sprintf(pnt, "{ \"setSwitchVector\": { \"device\": \"%s\", \"name\": \"%s\", \"state\": \"%s\"", property->device, property->name, indigo_property_state_text[property->state]);
-			pnt += size;
-			if (message) {
-				size = sprintf(pnt, ", \"message\": \"%s\", \"items\": [ ", message);
-				pnt += size;
-			} else {
-				size = sprintf(pnt, ", \"items\": [ ");
-				pnt += size;
-			}
+			write_update_start(buffer, "setSwitchVector", property);
+			write_items_start(buffer, false, message);
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
-				size = sprintf(pnt, "%s { \"name\": \"%s\", \"value\": %s }",  i > 0 ? "," : "", item->name, item->sw.value ? "true" : "false");
-				pnt += size;
+				write_item_start(buffer, i, item);
+				if (item->sw.value)
+					write_literal(buffer, ", \"value\": true }");
+				else
+					write_literal(buffer, ", \"value\": false }");
 			}
-			size = sprintf(pnt, " ] } }");
-			size += pnt - output_buffer;
 			break;
 		case INDIGO_LIGHT_VECTOR:
-			size = sprintf(pnt, "{ \"setLightVector\": { \"device\": \"%s\", \"name\": \"%s\", \"state\": \"%s\"", property->device, property->name, indigo_property_state_text[property->state]);
-			pnt += size;
-			if (message) {
-				size = sprintf(pnt, ", \"message\": \"%s\", \"items\": [ ", message);
-				pnt += size;
-			} else {
-				size = sprintf(pnt, ", \"items\": [ ");
-				pnt += size;
-			}
+			write_update_start(buffer, "setLightVector", property);
+			write_items_start(buffer, false, message);
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
-				size = sprintf(pnt, "%s { \"name\": \"%s\", \"value\": \"%s\" }",  i > 0 ? "," : "", item->name, indigo_property_state_text[item->light.value]);
-				pnt += size;
+				write_item_start(buffer, i, item);
+				indigo_buffer_printf(buffer, ", \"value\": \"%s\" }", indigo_property_state_text[item->light.value]);
 			}
-			size = sprintf(pnt, " ] } }");
-			size += pnt - output_buffer;
 			break;
 		case INDIGO_BLOB_VECTOR:
-			size = sprintf(pnt, "{ \"setBLOBVector\": { \"device\": \"%s\", \"name\": \"%s\", \"state\": \"%s\"", property->device, property->name, indigo_property_state_text[property->state]);
-			pnt += size;
-			if (message) {
-				size = sprintf(pnt, ", \"message\": \"%s\", \"items\": [ ", message);
-				pnt += size;
-			} else {
-				size = sprintf(pnt, ", \"items\": [ ");
-				pnt += size;
+			write_update_start(buffer, "setBLOBVector", property);
+			write_items_start(buffer, false, message);
+			for (int i = 0; i < property->count; i++) {
+				indigo_item *item = &property->items[i];
+				write_item_start(buffer, i, item);
+				if (property->state == INDIGO_OK_STATE) {
+					indigo_buffer_printf(buffer, ", \"value\": \"/blob/%p", item);
+					indigo_buffer_json_escape(buffer, item->blob.format);
+					write_literal(buffer, "\" }");
+				} else {
+					write_literal(buffer, " }");
+				}
 			}
+			break;
+		case INDIGO_ARRAY_VECTOR:
+			write_update_start(buffer, "setArrayVector", property);
+			write_items_start(buffer, false, message);
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = &property->items[i];
-				if (property->state == INDIGO_OK_STATE)
-					size = sprintf(pnt, "%s { \"name\": \"%s\", \"value\": \"/blob/%p%s\" }", i > 0 ? "," : "", item->name, item, item->blob.format);
-				else
-					size = sprintf(pnt, "%s { \"name\": \"%s\" }", i > 0 ? "," : "", item->name);
-				pnt += size;
+				write_item_start(buffer, i, item);
+				indigo_buffer_printf(buffer, ", \"type\": \"%s\", \"shape\": [", indigo_array_type_text[item->array.type]);
+				for (int j = 0; j < item->array.rank; j++)
+					indigo_buffer_printf(buffer, "%s %d", j > 0 ? "," : "", item->array.shape[j]);
+				write_literal(buffer, " ], \"value\": [");
+				write_array_values(buffer, item);
+				write_literal(buffer, "] }");
 			}
-			size = sprintf(pnt, " ] } }");
-			size += pnt - output_buffer;
 			break;
 	}
-	if (client_context->web_socket)
-		ws_write(handle, output_buffer, size);
-	else
-		indigo_write(handle, output_buffer, size);
-	INDIGO_TRACE_PROTOCOL(indigo_trace("sent: %s\n", output_buffer));
-	pthread_mutex_unlock(&json_mutex);
+	write_literal(buffer, " ] } }");
+}
+
+static indigo_result json_update_property(indigo_client *client, struct indigo_device *device, indigo_property *property, const char *message) {
+	assert(device != NULL);
+	assert(client != NULL);
+	assert(property != NULL);
+	if (client->version == INDIGO_VERSION_NONE)
+		return INDIGO_OK;
+	if (property->type == INDIGO_BLOB_VECTOR ? client->enable_blob == INDIGO_ENABLE_BLOB_NEVER : client->enable_blob == INDIGO_ENABLE_BLOB_ONLY)
+		return INDIGO_OK;
+	indigo_property *shared = property;
+	property = indigo_acquire_property_snapshot(shared);
+	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
+	assert(client_context != NULL);
+	pthread_mutex_lock(&client_context->output_mutex);
+	indigo_output_buffer *buffer = client_context->output_buffer;
+	indigo_shared_output *shared_output = indigo_get_shared_output(shared, JSON_OUTPUT_KEY);
+	if (shared_output != NULL && shared_output->uses > 1) {
+		/* the first client gets message serialized directly to its buffer, all others share another copy */
+		if (shared_output->buffer == NULL) {
+			shared_output->buffer = indigo_create_output_buffer(-1);
+			write_update(shared_output->buffer, property, message);
+		}
+		buffer = shared_output->buffer;
+	} else {
+		buffer->length = 0;
+		write_update(buffer, property, message);
+	}
+	send_message(client_context, buffer->data, buffer->length);
+	if (property->type == INDIGO_BLOB_VECTOR && property->state == INDIGO_OK_STATE && client_context->web_socket && client->enable_blob != INDIGO_ENABLE_BLOB_URL) {
+		for (int i = 0; i < property->count; i++) {
+			indigo_item *item = &property->items[i];
+			if (item->blob.value != NULL)
+				ws_write_blob(client_context, property, item);
+		}
+	}
+	indigo_release_property_snapshot(shared, property);
+	pthread_mutex_unlock(&client_context->output_mutex);
 	return INDIGO_OK;
 }
 
@@ -305,49 +396,74 @@ static indigo_result json_delete_property(indigo_client *client, struct indigo_d
 	assert(property != NULL);
 	if (client->version == INDIGO_VERSION_NONE)
 		return INDIGO_OK;
-	pthread_mutex_lock(&json_mutex);
 	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
 	assert(client_context != NULL);
-	int handle = client_context->output;
-	char output_buffer[JSON_BUFFER_SIZE];
-	char *pnt = output_buffer;
-	int size;
-	if (*property->name == 0)
-		size = sprintf(pnt, "{ \"deleteProperty\": { \"device\": \"%s\"", device->name);
-	else
-		size = sprintf(pnt, "{ \"deleteProperty\": { \"device\": \"%s\", \"name\": \"%s\"", property->device, property->name);
-	pnt += size;
-	if (message) {
-		size = sprintf(pnt, ", \"message\": \"%s\" } }", message);
+	pthread_mutex_lock(&client_context->output_mutex);
+	indigo_output_buffer *buffer = client_context->output_buffer;
+	buffer->length = 0;
+	if (*property->name == 0) {
+		write_string(buffer, "{ \"deleteProperty\": { \"device\": ", device->name);
 	} else {
-		size = sprintf(pnt, " } }");
+		write_string(buffer, "{ \"deleteProperty\": { \"device\": ", property->device);
+		write_string(buffer, ", \"name\": ", property->name);
 	}
-	size += pnt - output_buffer;
-	if (client_context->web_socket)
-		ws_write(handle, output_buffer, size);
-	else
-		indigo_write(handle, output_buffer, size);
-	INDIGO_TRACE_PROTOCOL(indigo_trace("sent: %s\n", output_buffer));
-	pthread_mutex_unlock(&json_mutex);
+	if (message)
+		write_string(buffer, ", \"message\": ", message);
+	write_literal(buffer, " } }");
+	send_message(client_context, buffer->data, buffer->length);
+	pthread_mutex_unlock(&client_context->output_mutex);
+	return INDIGO_OK;
+}
+
+static indigo_result json_define_property_items(indigo_client *client, struct indigo_device *device, indigo_property *property, indigo_property *items, const char *message) {
+	assert(client != NULL);
+	if (client->version >= INDIGO_VERSION_2_0)
+		return define_property(client, device, items, message, true);
+	json_delete_property(client, device, property, NULL);
+	return define_property(client, device, property, message, false);
+}
+
+static indigo_result json_delete_property_items(indigo_client *client, struct indigo_device *device, indigo_property *property, indigo_property *items, const char *message) {
+	assert(device != NULL);
+	assert(client != NULL);
+	assert(items != NULL);
+	if (client->version == INDIGO_VERSION_NONE)
+		return INDIGO_OK;
+	if (client->version < INDIGO_VERSION_2_0) {
+		json_delete_property(client, device, property, NULL);
+		return define_property(client, device, property, message, false);
+	}
+	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
+	assert(client_context != NULL);
+	pthread_mutex_lock(&client_context->output_mutex);
+	indigo_output_buffer *buffer = client_context->output_buffer;
+	buffer->length = 0;
+	write_string(buffer, "{ \"deleteItems\": { \"device\": ", items->device);
+	write_string(buffer, ", \"name\": ", items->name);
+	write_items_start(buffer, false, message);
+	for (int i = 0; i < items->count; i++) {
+		write_item_start(buffer, i, items->items + i);
+		write_literal(buffer, " }");
+	}
+	write_literal(buffer, " ] } }");
+	send_message(client_context, buffer->data, buffer->length);
+	pthread_mutex_unlock(&client_context->output_mutex);
 	return INDIGO_OK;
 }
 
 static indigo_result json_message_property(indigo_client *client, struct indigo_device *device, const char *message) {
 	assert(device != NULL);
 	assert(client != NULL);
-	pthread_mutex_lock(&json_mutex);
 	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
 	assert(client_context != NULL);
-	int handle = client_context->output;
-	char output_buffer[JSON_BUFFER_SIZE];
-	char *pnt = output_buffer;
-	int size = sprintf(pnt, "{ \"message\": \"%s\" }", message);
-	if (client_context->web_socket)
-		ws_write(handle, output_buffer, size);
-	else
-		indigo_write(handle, output_buffer, size);
-	INDIGO_TRACE_PROTOCOL(indigo_trace("sent: %s\n", output_buffer));
-	pthread_mutex_unlock(&json_mutex);
+	pthread_mutex_lock(&client_context->output_mutex);
+	indigo_output_buffer *buffer = client_context->output_buffer;
+	buffer->length = 0;
+	// empty message relayed from chained server is broadcasted as NULL
+	write_string(buffer, "{ \"message\": ", message ? message : "");
+	write_literal(buffer, " }");
+	send_message(client_context, buffer->data, buffer->length);
+	pthread_mutex_unlock(&client_context->output_mutex);
 	return INDIGO_OK;
 }
 
@@ -361,14 +477,15 @@ static indigo_result json_detach(indigo_client *client) {
 
 indigo_client *indigo_json_device_adapter(int input, int ouput, bool web_socket) {
 	static indigo_client client_template = {
-		"", NULL, INDIGO_OK, INDIGO_VERSION_CURRENT, INDIGO_ENABLE_BLOB_ALSO,
+		"", NULL, INDIGO_OK, INDIGO_VERSION_CURRENT, INDIGO_ENABLE_BLOB_URL,
 		NULL,
 		json_define_property,
 		json_update_property,
 		json_delete_property,
 		json_message_property,
 		json_detach,
-
+		json_define_property_items,
+		json_delete_property_items
 	};
 	indigo_client *client = malloc(sizeof(indigo_client));
 	assert(client != NULL);
@@ -377,7 +494,11 @@ indigo_client *indigo_json_device_adapter(int input, int ouput, bool web_socket)
 	assert(client_context != NULL);
 	client_context->input = input;
 	client_context->output = ouput;
+	client_context->raw_blobs = false;
 	client_context->web_socket = web_socket;
+	client_context->compression = NULL;
+	client_context->output_buffer = indigo_create_output_buffer(-1);
+	pthread_mutex_init(&client_context->output_mutex, NULL);
 	client->client_context = client_context;
 	return client;
 }
@@ -385,6 +506,9 @@ indigo_client *indigo_json_device_adapter(int input, int ouput, bool web_socket)
 void indigo_release_json_device_adapter(indigo_client *client) {
 	assert(client != NULL);
 	assert(client->client_context != NULL);
+	indigo_ws_compression_release(((indigo_adapter_context *)client->client_context)->compression);
+	indigo_release_output_buffer(((indigo_adapter_context *)client->client_context)->output_buffer);
+	pthread_mutex_destroy(&((indigo_adapter_context *)client->client_context)->output_mutex);
 	free(client->client_context);
 	free(client);
 }
@@ -48,148 +48,280 @@
 #include "indigo_xml.h"
 #include "indigo_io.h"
 #include "indigo_base64.h"
+#include "indigo_dtoa.h"
 #include "indigo_version.h"
 #include "indigo_driver_xml.h"
 
-#define RAW_BUF_SIZE 98304
-#define BASE64_BUF_SIZE 131072  /* BASE64_BUF_SIZE >= (RAW_BUF_SIZE + 2) / 3 * 4 */
+#define RAW_BUF_SIZE 98280	/* multiple of 54 (legacy line) */
+#define BASE64_BUF_SIZE 133120  /* BASE64_BUF_SIZE >= (RAW_BUF_SIZE + 2) / 3 * 4 + RAW_BUF_SIZE / 54 + 1 */
 
-static pthread_mutex_t write_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* keys of output shared by all clients during update broadcast */
+#define XML_OUTPUT_KEY(client)				(('X' << 24) | ((long)(client)->enable_blob << 16) | (client)->version)
+#define XML_BLOB_KEY(index, legacy)		(('B' << 24) | ((long)(legacy) << 16) | (index))
 
-static const char *message_attribute(const char *message) {
+static void write_message_attribute(indigo_output_buffer *buffer, const char *message) {
 	if (message) {
-		static char buffer[INDIGO_VALUE_SIZE];
-		snprintf(buffer, INDIGO_VALUE_SIZE, " message='%s'", indigo_xml_escape((char *)message));
-		return buffer;
+		indigo_buffer_write(buffer, " message='", 10);
+		indigo_buffer_xml_escape(buffer, message);
+		indigo_buffer_write(buffer, "'", 1);
 	}
-	return "";
 }
 
-static indigo_result xml_device_adapter_define_property(indigo_client *client, struct indigo_device *device, indigo_property *property, const char *message) {
+static void write_definition_start(indigo_output_buffer *buffer, const char *tag, indigo_client *client, indigo_property *property, bool delta, const char *message) {
+	indigo_buffer_printf(buffer, "<%s device='", tag);
+	indigo_buffer_xml_escape(buffer, property->device);
+	indigo_buffer_printf(buffer, "' name='%s' group='", indigo_property_name(client->version, property));
+	indigo_buffer_xml_escape(buffer, property->group);
+	indigo_buffer_write(buffer, "' label='", 9);
+	indigo_buffer_xml_escape(buffer, property->label);
+	indigo_buffer_printf(buffer, "' perm='%s' state='%s'", indigo_property_perm_text[property->perm], indigo_property_state_text[property->state]);
+	if (property->type == INDIGO_SWITCH_VECTOR)
+		indigo_buffer_printf(buffer, " rule='%s'", indigo_switch_rule_text[property->rule]);
+	if (delta)
+		indigo_buffer_write(buffer, " delta='true'", 13);
+	write_message_attribute(buffer, message);
+	indigo_buffer_write(buffer, ">\n", 2);
+}
+
+/* writes tag with item name and escaped label, other attributes are appended by caller */
+
+static void write_item_start(indigo_output_buffer *buffer, const char *tag, indigo_client *client, indigo_property *property, indigo_item *item) {
+	indigo_buffer_printf(buffer, "<%s name='%s' label='", tag, indigo_item_name(client->version, property, item));
+	indigo_buffer_xml_escape(buffer, item->label);
+	indigo_buffer_write(buffer, "'", 1);
+}
+
+static void write_update_start(indigo_output_buffer *buffer, const char *tag, indigo_client *client, indigo_property *property, const char *message) {
+	indigo_buffer_printf(buffer, "<%s device='", tag);
+	indigo_buffer_xml_escape(buffer, property->device);
+	indigo_buffer_printf(buffer, "' name='%s' state='%s'", indigo_property_name(client->version, property), indigo_property_state_text[property->state]);
+	write_message_attribute(buffer, message);
+	indigo_buffer_write(buffer, ">\n", 2);
+}
+
+static const char *array_shape_attribute(indigo_item *item) {
+	static __thread char buffer[INDIGO_NAME_SIZE];
+	char *pnt = buffer;
+	for (int i = 0; i < item->array.rank; i++)
+		pnt += snprintf(pnt, buffer + INDIGO_NAME_SIZE - pnt, i ? " %d" : "%d", item->array.shape[i]);
+	*pnt = 0;
+	return buffer;
+}
+
+static void write_array_value(indigo_output_buffer *buffer, indigo_item *item) {
+	/* 3072 raw = 4096 encoded */
+	char encoded_data[4096];
+	unsigned char *data = item->array.value;
+	long input_length = data ? item->array.count * indigo_array_element_size(item->array.type) : 0;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	/* elements are sent in little endian byte order, 3072 is a multiple of any element size */
+	unsigned char swapped_data[3072];
+	int element_size = indigo_array_element_size(item->array.type);
+#endif
+	while (input_length) {
+		long len = (3072 < input_length) ? 3072 : input_length;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		for (long i = 0; i < len; i += element_size)
+			for (int j = 0; j < element_size; j++)
+				swapped_data[i + j] = data[i + element_size - 1 - j];
+		long enclen = base64_encode((unsigned char*)encoded_data, swapped_data, len);
+#else
+		long enclen = base64_encode((unsigned char*)encoded_data, data, len);
+#endif
+		indigo_buffer_write(buffer, encoded_data, enclen);
+		input_length -= len;
+		data += len;
+	}
+}
+
+static long encode_blob_value(char *encoded_data, unsigned char *data, long input_length, bool legacy) {
+	/* legacy clients get lines of 72 characters */
+	if (legacy)
+		return base64_encode_nl((unsigned char*)encoded_data, data, input_length);
+	return base64_encode((unsigned char*)encoded_data, data, input_length);
+}
+
+static void write_blob_value(indigo_output_buffer *buffer, indigo_property *property, int index, bool legacy) {
+	indigo_item *item = property->items + index;
+	unsigned char *data = item->blob.value;
+	long input_length = data ? item->blob.size : 0;
+	indigo_shared_output *shared_output = indigo_get_shared_output(property, XML_BLOB_KEY(index, legacy));
+	if (shared_output != NULL) {
+		/* encoded once per broadcast and shared by all clients */
+		if (shared_output->buffer == NULL) {
+			shared_output->buffer = indigo_create_output_buffer(-1);
+			char *encoded_data = indigo_buffer_reserve(shared_output->buffer, (input_length + 2) / 3 * 4 + input_length / 54 + 5);
+			shared_output->buffer->length = encode_blob_value(encoded_data, data, input_length, legacy);
+		}
+		indigo_buffer_write(buffer, shared_output->buffer->data, shared_output->buffer->length);
+		return;
+	}
+	/* BLOB with single consumer or outside of broadcast is encoded and sent in chunks */
+	while (input_length) {
+		char encoded_data[BASE64_BUF_SIZE + 1];
+		long len = (RAW_BUF_SIZE < input_length) ?  RAW_BUF_SIZE : input_length;
+		long enclen = encode_blob_value(encoded_data, data, len, legacy);
+		indigo_buffer_write(buffer, encoded_data, enclen);
+		input_length -= len;
+		data += len;
+	}
+}
+
+static indigo_result define_property(indigo_client *client, struct indigo_device *device, indigo_property *property, const char *message, bool delta) {
 	assert(device != NULL);
 	assert(client != NULL);
 	assert(property != NULL);
 	if (client->version == INDIGO_VERSION_NONE)
 		return INDIGO_OK;
-	pthread_mutex_lock(&write_mutex);
+	indigo_property *shared = property;
+	property = indigo_acquire_property_snapshot(shared);
 	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
 	assert(client_context != NULL);
-	int handle = client_context->output;
+	pthread_mutex_lock(&client_context->output_mutex);
+	indigo_output_buffer *buffer = client_context->output_buffer;
 	switch (property->type) {
 	case INDIGO_TEXT_VECTOR:
-		indigo_printf(handle, "<defTextVector device='%s' name='%s' group='%s' label='%s' perm='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_xml_escape(property->group), indigo_xml_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], message_attribute(message));
+		write_definition_start(buffer, "defTextVector", client, property, delta, message);
 		for (int i = 0; i < property->count; i++) {
 			indigo_item *item = &property->items[i];
-			indigo_printf(handle, "<defText name='%s' label='%s'>%s</defText>\n", indigo_item_name(client->version, property, item), item->label, item->text.value);
+			write_item_start(buffer, "defText", client, property, item);
+			indigo_buffer_write(buffer, ">", 1);
+			indigo_buffer_xml_escape(buffer, item->text.value);
+			indigo_buffer_write(buffer, "</defText>\n", 11);
 		}
-		indigo_printf(handle, "</defTextVector>\n");
+		indigo_buffer_printf(buffer, "</defTextVector>\n");
 		break;
 	case INDIGO_NUMBER_VECTOR:
-		indigo_printf(handle, "<defNumberVector device='%s' name='%s' group='%s' label='%s' perm='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_xml_escape(property->group), indigo_xml_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], message_attribute(message));
+		write_definition_start(buffer, "defNumberVector", client, property, delta, message);
 		for (int i = 0; i < property->count; i++) {
 			indigo_item *item = &property->items[i];
-			if (client->version >= INDIGO_VERSION_2_0 && property->perm != INDIGO_RO_PERM)
-				indigo_printf(handle, "<defNumber name='%s' label='%s' format='%s' min='%g' max='%g' step='%g' target='%g'>%g</defNumber>\n", indigo_item_name(client->version, property, item), item->label, item->number.format, item->number.min, item->number.max, item->number.step, item->number.target, item->number.value);
-			else
-				indigo_printf(handle, "<defNumber name='%s' label='%s' format='%s' min='%g' max='%g' step='%g'>%g</defNumber>\n", indigo_item_name(client->version, property, item), item->label, item->number.format, item->number.min, item->number.max, item->number.step, item->number.value);
+			char min[INDIGO_DTOA_SIZE], max[INDIGO_DTOA_SIZE], step[INDIGO_DTOA_SIZE], value[INDIGO_DTOA_SIZE];
+			indigo_dtoa(item->number.min, min);
+			indigo_dtoa(item->number.max, max);
+			indigo_dtoa(item->number.step, step);
+			indigo_dtoa(item->number.value, value);
+			write_item_start(buffer, "defNumber", client, property, item);
+			if (client->version >= INDIGO_VERSION_2_0 && property->perm != INDIGO_RO_PERM) {
+				char target[INDIGO_DTOA_SIZE];
+				indigo_dtoa(item->number.target, target);
+				indigo_buffer_printf(buffer, " format='%s' min='%s' max='%s' step='%s' target='%s'>%s</defNumber>\n", item->number.format, min, max, step, target, value);
+			} else {
+				indigo_buffer_printf(buffer, " format='%s' min='%s' max='%s' step='%s'>%s</defNumber>\n", item->number.format, min, max, step, value);
+			}
 		}
-		indigo_printf(handle, "</defNumberVector>\n");
+		indigo_buffer_printf(buffer, "</defNumberVector>\n");
 		break;
 	case INDIGO_SWITCH_VECTOR:
-		indigo_printf(handle, "<defSwitchVector device='%s' name='%s' group='%s' label='%s' perm='%s' state='%s' rule='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_xml_escape(property->group), indigo_xml_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], indigo_switch_rule_text[property->rule], message_attribute(message));
+		write_definition_start(buffer, "defSwitchVector", client, property, delta, message);
 		for (int i = 0; i < property->count; i++) {
 			indigo_item *item = &property->items[i];
-			indigo_printf(handle, "<defSwitch name='%s' label='%s'>%s</defSwitch>\n", indigo_item_name(client->version, property, item), item->label, item->sw.value ? "On" : "Off");
+			write_item_start(buffer, "defSwitch", client, property, item);
+			indigo_buffer_printf(buffer, ">%s</defSwitch>\n", item->sw.value ? "On" : "Off");
 		}
-		indigo_printf(handle, "</defSwitchVector>\n");
+		indigo_buffer_printf(buffer, "</defSwitchVector>\n");
 		break;
 	case INDIGO_LIGHT_VECTOR:
-		indigo_printf(handle, "<defLightVector device='%s' name='%s' group='%s' label='%s' perm='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_xml_escape(property->group), indigo_xml_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], message_attribute(message));
+		write_definition_start(buffer, "defLightVector", client, property, delta, message);
 		for (int i = 0; i < property->count; i++) {
 			indigo_item *item = &property->items[i];
-			indigo_printf(handle, " <defLight name='%s' label='%s'>%s</defLight>\n", indigo_item_name(client->version, property, item), item->label, indigo_property_state_text[item->light.value]);
+			write_item_start(buffer, "defLight", client, property, item);
+			indigo_buffer_printf(buffer, ">%s</defLight>\n", indigo_property_state_text[item->light.value]);
 		}
-		indigo_printf(handle, "</defLightVector>\n");
+		indigo_buffer_printf(buffer, "</defLightVector>\n");
 		break;
 	case INDIGO_BLOB_VECTOR:
-		indigo_printf(handle, "<defBLOBVector device='%s' name='%s' group='%s' label='%s' perm='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_xml_escape(property->group), indigo_xml_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], message_attribute(message));
+		write_definition_start(buffer, "defBLOBVector", client, property, delta, message);
 		for (int i = 0; i < property->count; i++) {
 			indigo_item *item = &property->items[i];
+			write_item_start(buffer, "defBLOB", client, property, item);
 			if (client->enable_blob == INDIGO_ENABLE_BLOB_URL) {
 				if (*item->blob.url == 0)
-					indigo_printf(handle, "<defBLOB name='%s' label='%s' path='/blob/%p%s'/>\n", indigo_item_name(client->version, property, item), item->label, item, item->blob.format);
+					indigo_buffer_printf(buffer, " path='/blob/%p%s'/>\n", item, item->blob.format);
 				else
-					indigo_printf(handle, "<defBLOB name='%s' label='%s' url='%s'/>\n", indigo_item_name(client->version, property, item), item->label, item->blob.url);
+					indigo_buffer_printf(buffer, " url='%s'/>\n", item->blob.url);
 			} else {
-				indigo_printf(handle, "<defBLOB name='%s' label='%s'/>\n", indigo_item_name(client->version, property, item), item->label);
+				indigo_buffer_write(buffer, "/>\n", 3);
+			}
+		}
+		indigo_buffer_printf(buffer, "</defBLOBVector>\n");
+		break;
+	case INDIGO_ARRAY_VECTOR:
+		if (client->version >= INDIGO_VERSION_2_0) {
+			write_definition_start(buffer, "defArrayVector", client, property, delta, message);
+			for (int i = 0; i < property->count; i++) {
+				indigo_item *item = &property->items[i];
+				write_item_start(buffer, "defArray", client, property, item);
+				indigo_buffer_printf(buffer, " type='%s'/>\n", indigo_array_type_text[item->array.type]);
 			}
+			indigo_buffer_printf(buffer, "</defArrayVector>\n");
 		}
-		indigo_printf(handle, "</defBLOBVector>\n");
 		break;
 	}
-	pthread_mutex_unlock(&write_mutex);
+	indigo_release_property_snapshot(shared, property);
+	indigo_buffer_flush(buffer);
+	pthread_mutex_unlock(&client_context->output_mutex);
 	return INDIGO_OK;
 }
 
-static indigo_result xml_device_adapter_update_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
-	FILE* fh;
-	int handle2;
-	assert(device != NULL);
-	assert(client != NULL);
-	assert(property != NULL);
-	if (client->version == INDIGO_VERSION_NONE)
-		return INDIGO_OK;
-	pthread_mutex_lock(&write_mutex);
-	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
-	assert(client_context != NULL);
-	int handle = client_context->output;
+static indigo_result xml_device_adapter_define_property(indigo_client *client, struct indigo_device *device, indigo_property *property, const char *message) {
+	return define_property(client, device, property, message, false);
+}
+
+static void write_update(indigo_output_buffer *buffer, indigo_client *client, indigo_adapter_context *client_context, indigo_property *property, const char *message) {
 	switch (property->type) {
 		case INDIGO_TEXT_VECTOR:
 			if (client->enable_blob != INDIGO_ENABLE_BLOB_ONLY) {
-				indigo_printf(handle, "<setTextVector device='%s' name='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_property_state_text[property->state], message_attribute(message));
+				write_update_start(buffer, "setTextVector", client, property, message);
 				for (int i = 0; i < property->count; i++) {
 					indigo_item *item = &property->items[i];
-					indigo_printf(handle, "<oneText name='%s'>%s</oneText>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(item->text.value));
+					indigo_buffer_printf(buffer, "<oneText name='%s'>", indigo_item_name(client->version, property, item));
+					indigo_buffer_xml_escape(buffer, item->text.value);
+					indigo_buffer_write(buffer, "</oneText>\n", 11);
 				}
-				indigo_printf(handle, "</setTextVector>\n");
+				indigo_buffer_printf(buffer, "</setTextVector>\n");
 			}
 			break;
 		case INDIGO_NUMBER_VECTOR:
 			if (client->enable_blob != INDIGO_ENABLE_BLOB_ONLY) {
-				indigo_printf(handle, "<setNumberVector device='%s' name='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_property_state_text[property->state], message_attribute(message));
+				write_update_start(buffer, "setNumberVector", client, property, message);
 				for (int i = 0; i < property->count; i++) {
 					indigo_item *item = &property->items[i];
-					if (client->version >= INDIGO_VERSION_2_0 && property->perm != INDIGO_RO_PERM)
-						indigo_printf(handle, "<oneNumber name='%s' target='%g'>%g</oneNumber>\n", indigo_item_name(client->version, property, item), item->number.target, item->number.value);
-					else
-						indigo_printf(handle, "<oneNumber name='%s'>%g</oneNumber>\n", indigo_item_name(client->version, property, item), item->number.value);
+					char value[INDIGO_DTOA_SIZE];
+					indigo_dtoa(item->number.value, value);
+					if (client->version >= INDIGO_VERSION_2_0 && property->perm != INDIGO_RO_PERM) {
+						char target[INDIGO_DTOA_SIZE];
+						indigo_dtoa(item->number.target, target);
+						indigo_buffer_printf(buffer, "<oneNumber name='%s' target='%s'>%s</oneNumber>\n", indigo_item_name(client->version, property, item), target, value);
+					} else {
+						indigo_buffer_printf(buffer, "<oneNumber name='%s'>%s</oneNumber>\n", indigo_item_name(client->version, property, item), value);
+					}
 				}
-				indigo_printf(handle, "</setNumberVector>\n");
+				indigo_buffer_printf(buffer, "</setNumberVector>\n");
 			}
 			break;
 		case INDIGO_SWITCH_VECTOR:
 			if (client->enable_blob != INDIGO_ENABLE_BLOB_ONLY) {
-				indigo_printf(handle, "<setSwitchVector device='%s' name='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_property_state_text[property->state], message_attribute(message));
+				write_update_start(buffer, "setSwitchVector", client, property, message);
 				for (int i = 0; i < property->count; i++) {
 					indigo_item *item = &property->items[i];
-					indigo_printf(handle, "<oneSwitch name='%s'>%s</oneSwitch>\n", indigo_item_name(client->version, property, item), item->sw.value ? "On" : "Off");
+					indigo_buffer_printf(buffer, "<oneSwitch name='%s'>%s</oneSwitch>\n", indigo_item_name(client->version, property, item), item->sw.value ? "On" : "Off");
 				}
-				indigo_printf(handle, "</setSwitchVector>\n");
+				indigo_buffer_printf(buffer, "</setSwitchVector>\n");
 			}
 			break;
 		case INDIGO_LIGHT_VECTOR:
 			if (client->enable_blob != INDIGO_ENABLE_BLOB_ONLY) {
-				indigo_printf(handle, "<setLightVector device='%s' name='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_property_state_text[property->state], message_attribute(message));
+				write_update_start(buffer, "setLightVector", client, property, message);
 				for (int i = 0; i < property->count; i++) {
 					indigo_item *item = &property->items[i];
-					indigo_printf(handle, "<oneLight name='%s'>%s</oneLight>\n", indigo_item_name(client->version, property, item), indigo_property_state_text[item->light.value]);
+					indigo_buffer_printf(buffer, "<oneLight name='%s'>%s</oneLight>\n", indigo_item_name(client->version, property, item), indigo_property_state_text[item->light.value]);
 				}
-				indigo_printf(handle, "</setLightVector>\n");
+				indigo_buffer_printf(buffer, "</setLightVector>\n");
 			}
 			break;
 		case INDIGO_BLOB_VECTOR:
 			if (client->enable_blob != INDIGO_ENABLE_BLOB_NEVER) {
-				indigo_printf(handle, "<setBLOBVector device='%s' name='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_property_state_text[property->state], message_attribute(message));
+				write_update_start(buffer, "setBLOBVector", client, property, message);
 				if (property->state == INDIGO_OK_STATE) {
 					for (int i = 0; i < property->count; i++) {
 						indigo_item *item = &property->items[i];
@@ -197,45 +329,65 @@ static indigo_result xml_device_adapter_update_property(indigo_client *client, i
 						unsigned char *data = item->blob.value;
 						if (client->enable_blob == INDIGO_ENABLE_BLOB_URL) {
 							if (*item->blob.url == 0)
-								indigo_printf(handle, "<oneBLOB name='%s' path='/blob/%p%s'/>\n", indigo_item_name(client->version, property, item), item, item->blob.format);
+								indigo_buffer_printf(buffer, "<oneBLOB name='%s' path='/blob/%p%s'/>\n", indigo_item_name(client->version, property, item), item, item->blob.format);
 							else
-								indigo_printf(handle, "<oneBLOB name='%s' url='%s'/>\n", indigo_item_name(client->version, property, item), item->blob.url);
+								indigo_buffer_printf(buffer, "<oneBLOB name='%s' url='%s'/>\n", indigo_item_name(client->version, property, item), item->blob.url);
+						} else if (client_context->raw_blobs) {
+							indigo_buffer_printf(buffer, "<oneBLOB name='%s' format='%s' size='%ld'>", indigo_item_name(client->version, property, item), item->blob.format, item->blob.size);
+							indigo_buffer_write(buffer, (const char *)data, input_length);
+							indigo_buffer_printf(buffer, "</oneBLOB>\n");
 						} else {
-							indigo_printf(handle, "<oneBLOB name='%s' format='%s' size='%ld'>\n", indigo_item_name(client->version, property, item), item->blob.format, item->blob.size);
-							handle2 = dup(handle);
-							fh = fdopen(handle2, "w");
-							if (property->version >= INDIGO_VERSION_2_0) {
-								while (input_length) {
-									char encoded_data[BASE64_BUF_SIZE + 1];
-									long len = (RAW_BUF_SIZE < input_length) ?  RAW_BUF_SIZE : input_length;
-									long enclen = base64_encode((unsigned char*)encoded_data, (unsigned char*)data, len);
-									fwrite(encoded_data, 1, enclen, fh);
-									input_length -= len;
-									data += len;
-								}
-							} else {
-								static char encoded_data[74];
-								while (input_length) {
-									/* 54 raw = 72 encoded */
-									long len = (54 < input_length) ?  54 : input_length;
-									long enclen = base64_encode((unsigned char*)encoded_data, (unsigned char*)data, len);
-									encoded_data[enclen] = '\n';
-									fwrite(encoded_data, 1, enclen, fh);
-									input_length -= len;
-									data += len;
-								}
-							}
-							fflush(fh);
-							fclose(fh);
-							indigo_printf(handle, "</oneBLOB>\n");
+							indigo_buffer_printf(buffer, "<oneBLOB name='%s' format='%s' size='%ld'>\n", indigo_item_name(client->version, property, item), item->blob.format, item->blob.size);
+							write_blob_value(buffer, property, i, property->version < INDIGO_VERSION_2_0);
+							indigo_buffer_printf(buffer, "</oneBLOB>\n");
 						}
 					}
 				}
-				indigo_printf(handle, "</setBLOBVector>\n");
+				indigo_buffer_printf(buffer, "</setBLOBVector>\n");
+			}
+			break;
+		case INDIGO_ARRAY_VECTOR:
+			if (client->version >= INDIGO_VERSION_2_0 && client->enable_blob != INDIGO_ENABLE_BLOB_ONLY) {
+				write_update_start(buffer, "setArrayVector", client, property, message);
+				for (int i = 0; i < property->count; i++) {
+					indigo_item *item = &property->items[i];
+					indigo_buffer_printf(buffer, "<oneArray name='%s' type='%s' shape='%s'>", indigo_item_name(client->version, property, item), indigo_array_type_text[item->array.type], array_shape_attribute(item));
+					write_array_value(buffer, item);
+					indigo_buffer_printf(buffer, "</oneArray>\n");
+				}
+				indigo_buffer_printf(buffer, "</setArrayVector>\n");
 			}
 			break;
 	}
-	pthread_mutex_unlock(&write_mutex);
+}
+
+static indigo_result xml_device_adapter_update_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
+	assert(device != NULL);
+	assert(client != NULL);
+	assert(property != NULL);
+	if (client->version == INDIGO_VERSION_NONE)
+		return INDIGO_OK;
+	indigo_property *shared = property;
+	property = indigo_acquire_property_snapshot(shared);
+	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
+	assert(client_context != NULL);
+	pthread_mutex_lock(&client_context->output_mutex);
+	indigo_output_buffer *buffer = client_context->output_buffer;
+	indigo_shared_output *shared_output = property->type == INDIGO_BLOB_VECTOR ? NULL : indigo_get_shared_output(shared, XML_OUTPUT_KEY(client));
+	if (shared_output == NULL || shared_output->uses == 1) {
+		/* the first client gets message serialized directly to its buffer */
+		write_update(buffer, client, client_context, property, message);
+	} else {
+		/* serialized once more for all other clients with the same version and BLOB mode */
+		if (shared_output->buffer == NULL) {
+			shared_output->buffer = indigo_create_output_buffer(-1);
+			write_update(shared_output->buffer, client, client_context, property, message);
+		}
+		indigo_buffer_write(buffer, shared_output->buffer->data, shared_output->buffer->length);
+	}
+	indigo_release_property_snapshot(shared, property);
+	indigo_buffer_flush(buffer);
+	pthread_mutex_unlock(&client_context->output_mutex);
 	return INDIGO_OK;
 }
 
@@ -245,15 +397,60 @@ static indigo_result xml_device_adapter_delete_property(indigo_client *client, i
 	assert(property != NULL);
 	if (client->version == INDIGO_VERSION_NONE)
 		return INDIGO_OK;
-	pthread_mutex_lock(&write_mutex);
+	if (property->type == INDIGO_ARRAY_VECTOR && client->version < INDIGO_VERSION_2_0)
+		return INDIGO_OK;
 	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
 	assert(client_context != NULL);
-	int handle = client_context->output;
-	if (*property->name)
-		indigo_printf(handle, "<delProperty device='%s' name='%s'%s/>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), message_attribute(message));
-	else
-		indigo_printf(handle, "<delProperty device='%s'%s/>\n", device->name, message_attribute(message));
-	pthread_mutex_unlock(&write_mutex);
+	pthread_mutex_lock(&client_context->output_mutex);
+	indigo_output_buffer *buffer = client_context->output_buffer;
+	if (*property->name) {
+		indigo_buffer_write(buffer, "<delProperty device='", 21);
+		indigo_buffer_xml_escape(buffer, property->device);
+		indigo_buffer_printf(buffer, "' name='%s'", indigo_property_name(client->version, property));
+	} else {
+		indigo_buffer_printf(buffer, "<delProperty device='%s'", device->name);
+	}
+	write_message_attribute(buffer, message);
+	indigo_buffer_write(buffer, "/>\n", 3);
+	indigo_buffer_flush(buffer);
+	pthread_mutex_unlock(&client_context->output_mutex);
+	return INDIGO_OK;
+}
+
+static indigo_result xml_device_adapter_define_property_items(indigo_client *client, struct indigo_device *device, indigo_property *property, indigo_property *items, const char *message) {
+	assert(client != NULL);
+	if (client->version >= INDIGO_VERSION_2_0)
+		return define_property(client, device, items, message, true);
+	xml_device_adapter_delete_property(client, device, property, NULL);
+	return define_property(client, device, property, message, false);
+}
+
+static indigo_result xml_device_adapter_delete_property_items(indigo_client *client, struct indigo_device *device, indigo_property *property, indigo_property *items, const char *message) {
+	assert(device != NULL);
+	assert(client != NULL);
+	assert(items != NULL);
+	if (client->version == INDIGO_VERSION_NONE)
+		return INDIGO_OK;
+	if (client->version < INDIGO_VERSION_2_0) {
+		xml_device_adapter_delete_property(client, device, property, NULL);
+		return define_property(client, device, property, message, false);
+	}
+	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
+	assert(client_context != NULL);
+	pthread_mutex_lock(&client_context->output_mutex);
+	indigo_output_buffer *buffer = client_context->output_buffer;
+	indigo_buffer_write(buffer, "<delItems device='", 18);
+	indigo_buffer_xml_escape(buffer, items->device);
+	indigo_buffer_printf(buffer, "' name='%s'", indigo_property_name(client->version, items));
+	write_message_attribute(buffer, message);
+	indigo_buffer_write(buffer, ">\n", 2);
+	for (int i = 0; i < items->count; i++) {
+		indigo_item *item = &items->items[i];
+		indigo_buffer_printf(buffer, "<delItem name='%s'/>\n", indigo_item_name(client->version, items, item));
+	}
+	indigo_buffer_printf(buffer, "</delItems>\n");
+	indigo_buffer_flush(buffer);
+	pthread_mutex_unlock(&client_context->output_mutex);
 	return INDIGO_OK;
 }
 
@@ -262,13 +459,17 @@ static indigo_result xml_device_adapter_send_message(indigo_client *client, indi
 	assert(client != NULL);
 	if (client->version == INDIGO_VERSION_NONE)
 		return INDIGO_OK;
-	pthread_mutex_lock(&write_mutex);
 	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
 	assert(client_context != NULL);
-	int handle = client_context->output;
-	if (message)
-		indigo_printf(handle, "<message%s/>\n", message_attribute(message));
-	pthread_mutex_unlock(&write_mutex);
+	pthread_mutex_lock(&client_context->output_mutex);
+	indigo_output_buffer *buffer = client_context->output_buffer;
+	if (message) {
+		indigo_buffer_write(buffer, "<message", 8);
+		write_message_attribute(buffer, message);
+		indigo_buffer_write(buffer, "/>\n", 3);
+	}
+	indigo_buffer_flush(buffer);
+	pthread_mutex_unlock(&client_context->output_mutex);
 	return INDIGO_OK;
 }
 
@@ -280,7 +481,9 @@ indigo_client *indigo_xml_device_adapter(int input, int ouput) {
 		xml_device_adapter_update_property,
 		xml_device_adapter_delete_property,
 		xml_device_adapter_send_message,
-		NULL
+		NULL,
+		xml_device_adapter_define_property_items,
+		xml_device_adapter_delete_property_items
 	};
 	indigo_client *client = malloc(sizeof(indigo_client));
 	assert(client != NULL);
@@ -289,14 +492,30 @@ indigo_client *indigo_xml_device_adapter(int input, int ouput) {
 	assert(client_context != NULL);
 	client_context->input = input;
 	client_context->output = ouput;
+	client_context->raw_blobs = false;
+	client_context->output_buffer = indigo_create_output_buffer(ouput);
+	pthread_mutex_init(&client_context->output_mutex, NULL);
 	client->client_context = client_context;
 	return client;
 }
 
+void indigo_xml_device_adapter_cork(indigo_client *client, bool cork) {
+	assert(client != NULL);
+	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
+	if (client_context == NULL || client_context->output_buffer == NULL)
+		return;
+	pthread_mutex_lock(&client_context->output_mutex);
+	indigo_buffer_cork(client_context->output_buffer, cork);
+	pthread_mutex_unlock(&client_context->output_mutex);
+}
+
 void indigo_release_xml_device_adapter(indigo_client *client) {
 	assert(client != NULL);
 	assert(client->client_context != NULL);
-	free(client->client_context);
+	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
+	indigo_release_output_buffer(client_context->output_buffer);
+	pthread_mutex_destroy(&client_context->output_mutex);
+	free(client_context);
 	free(client);
 }
 
@@ -33,5 +33,9 @@
  */
 extern indigo_client *indigo_xml_device_adapter(int input, int ouput);
 
+/** Start or finish burst of messages sent to XML wire protocol client side adapter (output is written at the end of burst).
+ */
+extern void indigo_xml_device_adapter_cork(indigo_client *client, bool cork);
+
 #endif /* indigo_device_xml_h */
 
@@ -0,0 +1,374 @@
+// Copyright (c) 2016 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 Build 0 - PoC by Peter Polakovic <peter.polakovic@cloudmakers.eu>
+
+/** INDIGO locale independent number formatting and parsing
+ \file indigo_dtoa.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <locale.h>
+#include <assert.h>
+
+#include "indigo_dtoa.h"
+
+/* Grisu2 (F. Loitsch, "Printing Floating-Point Numbers Quickly and Accurately with Integers"), the result
+ * always parses back to the same value and is the shortest possible one in all but very rare cases.
+ */
+
+typedef struct {
+	uint64_t f;
+	int e;
+} diy_fp;
+
+/* normalized 10^k for k = -348, -340, ..., 340 */
+
+static const struct {
+	uint64_t f;
+	int e;
+} cached_powers[] = {
+	{ 0xfa8fd5a0081c0288ULL, -1220 }, { 0xbaaee17fa23ebf76ULL, -1193 }, { 0x8b16fb203055ac76ULL, -1166 }, { 0xcf42894a5dce35eaULL, -1140 },
+	{ 0x9a6bb0aa55653b2dULL, -1113 }, { 0xe61acf033d1a45dfULL, -1087 }, { 0xab70fe17c79ac6caULL, -1060 }, { 0xff77b1fcbebcdc4fULL, -1034 },
+	{ 0xbe5691ef416bd60cULL, -1007 }, { 0x8dd01fad907ffc3cULL, -980 }, { 0xd3515c2831559a83ULL, -954 }, { 0x9d71ac8fada6c9b5ULL, -927 },
+	{ 0xea9c227723ee8bcbULL, -901 }, { 0xaecc49914078536dULL, -874 }, { 0x823c12795db6ce57ULL, -847 }, { 0xc21094364dfb5637ULL, -821 },
+	{ 0x9096ea6f3848984fULL, -794 }, { 0xd77485cb25823ac7ULL, -768 }, { 0xa086cfcd97bf97f4ULL, -741 }, { 0xef340a98172aace5ULL, -715 },
+	{ 0xb23867fb2a35b28eULL, -688 }, { 0x84c8d4dfd2c63f3bULL, -661 }, { 0xc5dd44271ad3cdbaULL, -635 }, { 0x936b9fcebb25c996ULL, -608 },
+	{ 0xdbac6c247d62a584ULL, -582 }, { 0xa3ab66580d5fdaf6ULL, -555 }, { 0xf3e2f893dec3f126ULL, -529 }, { 0xb5b5ada8aaff80b8ULL, -502 },
+	{ 0x87625f056c7c4a8bULL, -475 }, { 0xc9bcff6034c13053ULL, -449 }, { 0x964e858c91ba2655ULL, -422 }, { 0xdff9772470297ebdULL, -396 },
+	{ 0xa6dfbd9fb8e5b88fULL, -369 }, { 0xf8a95fcf88747d94ULL, -343 }, { 0xb94470938fa89bcfULL, -316 }, { 0x8a08f0f8bf0f156bULL, -289 },
+	{ 0xcdb02555653131b6ULL, -263 }, { 0x993fe2c6d07b7facULL, -236 }, { 0xe45c10c42a2b3b06ULL, -210 }, { 0xaa242499697392d3ULL, -183 },
+	{ 0xfd87b5f28300ca0eULL, -157 }, { 0xbce5086492111aebULL, -130 }, { 0x8cbccc096f5088ccULL, -103 }, { 0xd1b71758e219652cULL, -77 },
+	{ 0x9c40000000000000ULL, -50 }, { 0xe8d4a51000000000ULL, -24 }, { 0xad78ebc5ac620000ULL, 3 }, { 0x813f3978f8940984ULL, 30 },
+	{ 0xc097ce7bc90715b3ULL, 56 }, { 0x8f7e32ce7bea5c70ULL, 83 }, { 0xd5d238a4abe98068ULL, 109 }, { 0x9f4f2726179a2245ULL, 136 },
+	{ 0xed63a231d4c4fb27ULL, 162 }, { 0xb0de65388cc8ada8ULL, 189 }, { 0x83c7088e1aab65dbULL, 216 }, { 0xc45d1df942711d9aULL, 242 },
+	{ 0x924d692ca61be758ULL, 269 }, { 0xda01ee641a708deaULL, 295 }, { 0xa26da3999aef774aULL, 322 }, { 0xf209787bb47d6b85ULL, 348 },
+	{ 0xb454e4a179dd1877ULL, 375 }, { 0x865b86925b9bc5c2ULL, 402 }, { 0xc83553c5c8965d3dULL, 428 }, { 0x952ab45cfa97a0b3ULL, 455 },
+	{ 0xde469fbd99a05fe3ULL, 481 }, { 0xa59bc234db398c25ULL, 508 }, { 0xf6c69a72a3989f5cULL, 534 }, { 0xb7dcbf5354e9beceULL, 561 },
+	{ 0x88fcf317f22241e2ULL, 588 }, { 0xcc20ce9bd35c78a5ULL, 614 }, { 0x98165af37b2153dfULL, 641 }, { 0xe2a0b5dc971f303aULL, 667 },
+	{ 0xa8d9d1535ce3b396ULL, 694 }, { 0xfb9b7cd9a4a7443cULL, 720 }, { 0xbb764c4ca7a44410ULL, 747 }, { 0x8bab8eefb6409c1aULL, 774 },
+	{ 0xd01fef10a657842cULL, 800 }, { 0x9b10a4e5e9913129ULL, 827 }, { 0xe7109bfba19c0c9dULL, 853 }, { 0xac2820d9623bf429ULL, 880 },
+	{ 0x80444b5e7aa7cf85ULL, 907 }, { 0xbf21e44003acdd2dULL, 933 }, { 0x8e679c2f5e44ff8fULL, 960 }, { 0xd433179d9c8cb841ULL, 986 },
+	{ 0x9e19db92b4e31ba9ULL, 1013 }, { 0xeb96bf6ebadf77d9ULL, 1039 }, { 0xaf87023b9bf0ee6bULL, 1066 },
+};
+
+static const uint64_t pow10_64[] = {
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+	100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+	100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+static const double pow10_double[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static diy_fp multiply(diy_fp x, diy_fp y) {
+	/* upper 64 bits of 128 bit product, rounded (no __int128 on 32 bit ARM) */
+	uint64_t a = x.f >> 32, b = x.f & 0xFFFFFFFF, c = y.f >> 32, d = y.f & 0xFFFFFFFF;
+	uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+	uint64_t tmp = (bd >> 32) + (ad & 0xFFFFFFFF) + (bc & 0xFFFFFFFF) + (1ULL << 31);
+	return (diy_fp){ ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), x.e + y.e + 64 };
+}
+
+static diy_fp normalize(diy_fp x) {
+	int shift = __builtin_clzll(x.f);
+	return (diy_fp){ x.f << shift, x.e - shift };
+}
+
+static diy_fp cached_power(int e, int *k) {
+	/* 10^-k such that binary exponent of product with w is in range -60..-32 */
+	double dk = (-61 - e) * 0.30102999566398114 + 347;
+	int index = (int)dk;
+	if (dk - index > 0.0)
+		index++;
+	index = (index >> 3) + 1;
+	*k = -(-348 + index * 8);
+	return (diy_fp){ cached_powers[index].f, cached_powers[index].e };
+}
+
+static void round_weed(char *digits, int length, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w) {
+	while (rest < wp_w && delta - rest >= ten_kappa && (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+		digits[length - 1]--;
+		rest += ten_kappa;
+	}
+}
+
+static int digit_gen(diy_fp w, diy_fp mp, uint64_t delta, char *digits, int *k) {
+	diy_fp one = { 1ULL << -mp.e, mp.e };
+	uint64_t wp_w = mp.f - w.f;
+	uint32_t p1 = (uint32_t)(mp.f >> -one.e);
+	uint64_t p2 = mp.f & (one.f - 1);
+	int kappa = 10;
+	while (kappa > 1 && p1 < pow10_64[kappa - 1])
+		kappa--;
+	int length = 0;
+	while (kappa > 0) {
+		uint32_t d = p1 / (uint32_t)pow10_64[kappa - 1];
+		p1 %= (uint32_t)pow10_64[kappa - 1];
+		if (d || length)
+			digits[length++] = '0' + d;
+		kappa--;
+		uint64_t rest = ((uint64_t)p1 << -one.e) + p2;
+		if (rest <= delta) {
+			*k += kappa;
+			round_weed(digits, length, delta, rest, pow10_64[kappa] << -one.e, wp_w);
+			return length;
+		}
+	}
+	while (true) {
+		p2 *= 10;
+		delta *= 10;
+		char d = (char)(p2 >> -one.e);
+		if (d || length)
+			digits[length++] = '0' + d;
+		p2 &= one.f - 1;
+		kappa--;
+		if (p2 < delta) {
+			*k += kappa;
+			round_weed(digits, length, delta, p2, one.f, -kappa < 20 ? wp_w * pow10_64[-kappa] : 0);
+			return length;
+		}
+	}
+}
+
+/* v = f * 2^e > 0, lower_closer if predecessor of v is closer than successor (v is power of two) */
+
+static int grisu2(uint64_t f, int e, bool lower_closer, char *digits, int *k) {
+	diy_fp v = { f, e };
+	diy_fp plus = normalize((diy_fp){ (v.f << 1) + 1, v.e - 1 });
+	diy_fp minus = lower_closer ? (diy_fp){ (v.f << 2) - 1, v.e - 2 } : (diy_fp){ (v.f << 1) - 1, v.e - 1 };
+	minus.f <<= minus.e - plus.e;
+	minus.e = plus.e;
+	diy_fp c_mk = cached_power(plus.e, k);
+	diy_fp w = multiply(normalize(v), c_mk);
+	diy_fp wp = multiply(plus, c_mk);
+	diy_fp wm = multiply(minus, c_mk);
+	wm.f++;
+	wp.f--;
+	return digit_gen(w, wp, wp.f - wm.f, digits, k);
+}
+
+/* value = 0.digits * 10^point */
+
+static int format_digits(char *buffer, const char *digits, int length, int point) {
+	char *pnt = buffer;
+	int exponent = point - 1;
+	if (exponent > -5 && exponent < 17) {
+		if (point >= length) {
+			memcpy(pnt, digits, length);
+			pnt += length;
+			memset(pnt, '0', point - length);
+			pnt += point - length;
+		} else if (point > 0) {
+			memcpy(pnt, digits, point);
+			pnt += point;
+			*pnt++ = '.';
+			memcpy(pnt, digits + point, length - point);
+			pnt += length - point;
+		} else {
+			*pnt++ = '0';
+			*pnt++ = '.';
+			memset(pnt, '0', -point);
+			pnt += -point;
+			memcpy(pnt, digits, length);
+			pnt += length;
+		}
+	} else {
+		*pnt++ = digits[0];
+		if (length > 1) {
+			*pnt++ = '.';
+			memcpy(pnt, digits + 1, length - 1);
+			pnt += length - 1;
+		}
+		*pnt++ = 'e';
+		if (exponent < 0) {
+			*pnt++ = '-';
+			exponent = -exponent;
+		} else {
+			*pnt++ = '+';
+		}
+		if (exponent >= 100)
+			*pnt++ = '0' + exponent / 100;
+		*pnt++ = '0' + exponent / 10 % 10;
+		*pnt++ = '0' + exponent % 10;
+	}
+	*pnt = 0;
+	return (int)(pnt - buffer);
+}
+
+static int format_special(char *buffer, bool negative, bool zero, bool infinite) {
+	char *pnt = buffer;
+	if (negative)
+		*pnt++ = '-';
+	strcpy(pnt, zero ? "0" : infinite ? "inf" : "nan");
+	return (int)(pnt - buffer) + (int)strlen(pnt);
+}
+
+int indigo_dtoa(double value, char *buffer) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	bool negative = bits >> 63;
+	int biased_exponent = (bits >> 52) & 0x7FF;
+	uint64_t fraction = bits & 0xFFFFFFFFFFFFFULL;
+	if (biased_exponent == 0x7FF)
+		return format_special(buffer, negative && fraction == 0, false, fraction == 0);
+	if (biased_exponent == 0 && fraction == 0)
+		return format_special(buffer, negative, true, false);
+	char digits[24];
+	int k, length;
+	if (biased_exponent)
+		length = grisu2(fraction | 0x10000000000000ULL, biased_exponent - 1075, fraction == 0 && biased_exponent > 1, digits, &k);
+	else
+		length = grisu2(fraction, -1074, false, digits, &k);
+	if (negative)
+		*buffer = '-';
+	return negative + format_digits(buffer + negative, digits, length, length + k);
+}
+
+int indigo_ftoa(float value, char *buffer) {
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	bool negative = bits >> 31;
+	int biased_exponent = (bits >> 23) & 0xFF;
+	uint32_t fraction = bits & 0x7FFFFF;
+	if (biased_exponent == 0xFF)
+		return format_special(buffer, negative && fraction == 0, false, fraction == 0);
+	if (biased_exponent == 0 && fraction == 0)
+		return format_special(buffer, negative, true, false);
+	char digits[24];
+	int k, length;
+	if (biased_exponent)
+		length = grisu2(fraction | 0x800000, biased_exponent - 150, fraction == 0 && biased_exponent > 1, digits, &k);
+	else
+		length = grisu2(fraction, -149, false, digits, &k);
+	if (negative)
+		*buffer = '-';
+	return negative + format_digits(buffer + negative, digits, length, length + k);
+}
+
+/* Numbers with up to 19 significant digits and decimal exponent up to 22 are converted exactly by single
+ * multiplication or division (W. D. Clinger, "How to Read Floating Point Numbers Accurately"),
+ * the rest is passed to strtod() with decimal point of current locale.
+ */
+
+double indigo_strtod(const char *string, char **end) {
+	const char *pnt = string;
+	while (isspace((unsigned char)*pnt))
+		pnt++;
+	const char *start = pnt;
+	bool negative = false;
+	if (*pnt == '-' || *pnt == '+')
+		negative = *pnt++ == '-';
+	uint64_t mantissa = 0;
+	int digits = 0, exponent = 0;
+	bool any_digit = false, truncated = false;
+	while (isdigit((unsigned char)*pnt)) {
+		any_digit = true;
+		if (digits < 19) {
+			mantissa = mantissa * 10 + (*pnt - '0');
+			if (mantissa)
+				digits++;
+		} else {
+			truncated |= *pnt != '0';
+			exponent++;
+		}
+		pnt++;
+	}
+	if (*pnt == '.') {
+		pnt++;
+		while (isdigit((unsigned char)*pnt)) {
+			any_digit = true;
+			if (digits < 19) {
+				mantissa = mantissa * 10 + (*pnt - '0');
+				if (mantissa)
+					digits++;
+				exponent--;
+			} else {
+				truncated |= *pnt != '0';
+			}
+			pnt++;
+		}
+	}
+	if (!any_digit) {
+		/* "inf", "nan" or no number at all */
+		if (isalpha((unsigned char)*pnt))
+			return strtod(string, end);
+		if (end)
+			*end = (char *)string;
+		return 0;
+	}
+	if (*pnt == 'e' || *pnt == 'E') {
+		const char *exponent_pnt = pnt + 1;
+		bool negative_exponent = false;
+		if (*exponent_pnt == '-' || *exponent_pnt == '+')
+			negative_exponent = *exponent_pnt++ == '-';
+		if (isdigit((unsigned char)*exponent_pnt)) {
+			int value = 0;
+			while (isdigit((unsigned char)*exponent_pnt)) {
+				if (value < 100000)
+					value = value * 10 + (*exponent_pnt - '0');
+				exponent_pnt++;
+			}
+			exponent += negative_exponent ? -value : value;
+			pnt = exponent_pnt;
+		}
+	}
+	if (end)
+		*end = (char *)pnt;
+	if (mantissa == 0)
+		return negative ? -0.0 : 0.0;
+	if (!truncated && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+		double value = (double)mantissa;
+		value = exponent < 0 ? value / pow10_double[-exponent] : value * pow10_double[exponent];
+		return negative ? -value : value;
+	}
+	const char *decimal_point = localeconv()->decimal_point;
+	if (!strcmp(decimal_point, "."))
+		return strtod(start, NULL);
+	long decimal_point_length = strlen(decimal_point);
+	long length = pnt - start;
+	char local_copy[128];
+	char *copy = local_copy;
+	if (length + decimal_point_length >= (long)sizeof(local_copy)) {
+		copy = malloc(length + decimal_point_length + 1);
+		assert(copy != NULL);
+	}
+	char *target = copy;
+	for (const char *source = start; source < pnt; source++) {
+		if (*source == '.') {
+			memcpy(target, decimal_point, decimal_point_length);
+			target += decimal_point_length;
+		} else {
+			*target++ = *source;
+		}
+	}
+	*target = 0;
+	double value = strtod(copy, NULL);
+	if (copy != local_copy)
+		free(copy);
+	return value;
+}
+
+double indigo_atof(const char *string) {
+	return indigo_strtod(string, NULL);
+}
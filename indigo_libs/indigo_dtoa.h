@@ -0,0 +1,53 @@
+// Copyright (c) 2016 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 Build 0 - PoC by Peter Polakovic <peter.polakovic@cloudmakers.eu>
+
+/** INDIGO locale independent number formatting and parsing
+ \file indigo_dtoa.h
+
+ Numbers are always written and read with '.' as decimal separator regardless of LC_NUMERIC.
+ Formatted value is the shortest string parsed back to the same double (or float) value, fixed notation is used
+ for decimal exponents in range -5 < exponent < 17, exponential notation (e.g. "1.5e-07", "6.02214076e+23") otherwise.
+ */
+
+#ifndef indigo_dtoa_h
+#define indigo_dtoa_h
+
+/** Size of buffer large enough for any formatted value (incl. terminating zero).
+ */
+#define INDIGO_DTOA_SIZE	32
+
+/** Format double to buffer of INDIGO_DTOA_SIZE characters, return length of the string.
+ */
+extern int indigo_dtoa(double value, char *buffer);
+
+/** Format float to buffer of INDIGO_DTOA_SIZE characters, return length of the string.
+ */
+extern int indigo_ftoa(float value, char *buffer);
+
+/** Parse double like strtod() in "C" locale.
+ */
+extern double indigo_strtod(const char *string, char **end);
+
+/** Parse double like atof() in "C" locale.
+ */
+extern double indigo_atof(const char *string);
+
+#endif /* indigo_dtoa_h */
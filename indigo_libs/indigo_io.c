@@ -36,8 +36,12 @@
 #include <pthread.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
+#include <assert.h>
+#include <zlib.h>
 
 #include "indigo_bus.h"
 #include "indigo_io.h"
@@ -164,3 +168,325 @@ bool indigo_printf(int handle, const char *format, ...) {
 	INDIGO_DEBUG_PROTOCOL(indigo_debug("sent: %s", buffer));
 	return indigo_write(handle, buffer, length);
 }
+
+#define OUTPUT_BUFFER_SIZE	8192
+#define OUTPUT_BUFFER_LIMIT	65536 /* pending output is written when it reaches this size or when larger block is appended */
+#define STREAM_BUFFER_SIZE	65536
+#define STREAM_COMPRESSION_LEVEL	Z_DEFAULT_COMPRESSION
+
+struct indigo_deflater {
+	z_stream stream;
+	Bytef data[STREAM_BUFFER_SIZE];
+};
+
+struct indigo_inflater {
+	z_stream stream;
+	Bytef *data;
+	long size;
+};
+
+indigo_output_buffer *indigo_create_output_buffer(int handle) {
+	indigo_output_buffer *buffer = malloc(sizeof(indigo_output_buffer));
+	assert(buffer != NULL);
+	buffer->handle = handle;
+	buffer->data = malloc(OUTPUT_BUFFER_SIZE);
+	assert(buffer->data != NULL);
+	buffer->length = 0;
+	buffer->size = OUTPUT_BUFFER_SIZE;
+	buffer->corked = false;
+	buffer->deflater = NULL;
+	return buffer;
+}
+
+void indigo_release_output_buffer(indigo_output_buffer *buffer) {
+	assert(buffer != NULL);
+	buffer->corked = false;
+	indigo_buffer_flush(buffer);
+	if (buffer->deflater != NULL) {
+		deflateEnd(&buffer->deflater->stream);
+		free(buffer->deflater);
+	}
+	free(buffer->data);
+	free(buffer);
+}
+
+static bool deflate_block(indigo_output_buffer *buffer, const char *data, long length) {
+	z_stream *stream = &buffer->deflater->stream;
+	stream->next_in = (Bytef *)data;
+	stream->avail_in = (uInt)length;
+	do {
+		stream->next_out = buffer->deflater->data;
+		stream->avail_out = STREAM_BUFFER_SIZE;
+		int result = deflate(stream, Z_SYNC_FLUSH);
+		if (result != Z_OK && result != Z_BUF_ERROR)
+			return false;
+		long produced = STREAM_BUFFER_SIZE - stream->avail_out;
+		if (produced > 0 && !indigo_write(buffer->handle, (const char *)buffer->deflater->data, produced))
+			return false;
+	} while (stream->avail_out == 0);
+	return true;
+}
+
+static bool deflate_pending(indigo_output_buffer *buffer, const char *data, long length) {
+	bool result = deflate_block(buffer, buffer->data, buffer->length);
+	buffer->length = 0;
+	if (result && length > 0) {
+		/* large blocks (BLOB data) are stored, they are rarely worth of CPU time on the other side of slow link */
+		z_stream *stream = &buffer->deflater->stream;
+		stream->next_out = buffer->deflater->data;
+		stream->avail_out = STREAM_BUFFER_SIZE;
+		deflateParams(stream, Z_NO_COMPRESSION, Z_DEFAULT_STRATEGY);
+		result = deflate_block(buffer, data, length);
+		stream->next_out = buffer->deflater->data;
+		stream->avail_out = STREAM_BUFFER_SIZE;
+		deflateParams(stream, STREAM_COMPRESSION_LEVEL, Z_DEFAULT_STRATEGY);
+	}
+	return result;
+}
+
+static bool write_pending(indigo_output_buffer *buffer, const char *data, long length) {
+	if (buffer->deflater != NULL)
+		return deflate_pending(buffer, data, length);
+	struct iovec iov[2] = { { buffer->data, buffer->length }, { (void *)data, length } };
+	struct iovec *pnt = iov;
+	int count = 2;
+	if (buffer->length == 0) {
+		pnt++;
+		count--;
+	}
+	buffer->length = 0;
+	while (count > 0) {
+		ssize_t bytes_written = writev(buffer->handle, pnt, count);
+		if (bytes_written < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		while (count > 0 && bytes_written >= (ssize_t)pnt->iov_len) {
+			bytes_written -= pnt->iov_len;
+			pnt++;
+			count--;
+		}
+		if (count > 0) {
+			pnt->iov_base = (char *)pnt->iov_base + bytes_written;
+			pnt->iov_len -= bytes_written;
+		}
+	}
+	return true;
+}
+
+static void reserve(indigo_output_buffer *buffer, long length) {
+	if (buffer->length + length > buffer->size) {
+		long size = buffer->size * 2;
+		while (size < buffer->length + length)
+			size *= 2;
+		buffer->data = realloc(buffer->data, size);
+		assert(buffer->data != NULL);
+		buffer->size = size;
+	}
+}
+
+char *indigo_buffer_reserve(indigo_output_buffer *buffer, long length) {
+	assert(buffer != NULL);
+	reserve(buffer, length);
+	return buffer->data + buffer->length;
+}
+
+bool indigo_buffer_write(indigo_output_buffer *buffer, const char *data, long length) {
+	assert(buffer != NULL);
+	if (length >= OUTPUT_BUFFER_LIMIT && buffer->handle >= 0)
+		return write_pending(buffer, data, length);
+	reserve(buffer, length);
+	memcpy(buffer->data + buffer->length, data, length);
+	buffer->length += length;
+	if (buffer->length >= OUTPUT_BUFFER_LIMIT && buffer->handle >= 0)
+		return write_pending(buffer, NULL, 0);
+	return true;
+}
+
+bool indigo_buffer_printf(indigo_output_buffer *buffer, const char *format, ...) {
+	assert(buffer != NULL);
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(buffer->data + buffer->length, buffer->size - buffer->length, format, args);
+	va_end(args);
+	if (length < 0)
+		return false;
+	if (buffer->length + length >= buffer->size) {
+		reserve(buffer, length + 1);
+		va_start(args, format);
+		vsnprintf(buffer->data + buffer->length, buffer->size - buffer->length, format, args);
+		va_end(args);
+	}
+	INDIGO_DEBUG_PROTOCOL(indigo_debug("sent: %s", buffer->data + buffer->length));
+	buffer->length += length;
+	if (buffer->length >= OUTPUT_BUFFER_LIMIT && buffer->handle >= 0)
+		return write_pending(buffer, NULL, 0);
+	return true;
+}
+
+bool indigo_buffer_flush(indigo_output_buffer *buffer) {
+	assert(buffer != NULL);
+	if (buffer->corked || buffer->length == 0 || buffer->handle < 0)
+		return true;
+	return write_pending(buffer, NULL, 0);
+}
+
+bool indigo_buffer_cork(indigo_output_buffer *buffer, bool cork) {
+	assert(buffer != NULL);
+	int value = cork;
+	buffer->corked = cork;
+	bool result = cork ? true : indigo_buffer_flush(buffer);
+	if (buffer->handle < 0)
+		return result;
+#if defined(TCP_CORK)
+	setsockopt(buffer->handle, IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+#elif defined(TCP_NOPUSH)
+	setsockopt(buffer->handle, IPPROTO_TCP, TCP_NOPUSH, &value, sizeof(value));
+#endif
+	return result;
+}
+
+bool indigo_buffer_compress(indigo_output_buffer *buffer) {
+	assert(buffer != NULL);
+	assert(buffer->deflater == NULL);
+	if (buffer->length > 0 && buffer->handle >= 0 && !write_pending(buffer, NULL, 0))
+		return false;
+	struct indigo_deflater *deflater = malloc(sizeof(struct indigo_deflater));
+	assert(deflater != NULL);
+	memset(&deflater->stream, 0, sizeof(z_stream));
+	if (deflateInit2(&deflater->stream, STREAM_COMPRESSION_LEVEL, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		free(deflater);
+		return false;
+	}
+	buffer->deflater = deflater;
+	return true;
+}
+
+indigo_inflater *indigo_create_inflater(const char *data, long length) {
+	indigo_inflater *inflater = malloc(sizeof(indigo_inflater));
+	assert(inflater != NULL);
+	memset(&inflater->stream, 0, sizeof(z_stream));
+	inflater->size = length > STREAM_BUFFER_SIZE ? length : STREAM_BUFFER_SIZE;
+	inflater->data = malloc(inflater->size);
+	assert(inflater->data != NULL);
+	if (inflateInit2(&inflater->stream, -MAX_WBITS) != Z_OK) {
+		free(inflater->data);
+		free(inflater);
+		return NULL;
+	}
+	if (length > 0)
+		memcpy(inflater->data, data, length);
+	inflater->stream.next_in = inflater->data;
+	inflater->stream.avail_in = (uInt)length;
+	return inflater;
+}
+
+long indigo_inflater_read(indigo_inflater *inflater, int handle, char *buffer, long length) {
+	assert(inflater != NULL);
+	z_stream *stream = &inflater->stream;
+	stream->next_out = (Bytef *)buffer;
+	stream->avail_out = (uInt)length;
+	while (true) {
+		if (stream->avail_in == 0) {
+			ssize_t count = read(handle, inflater->data, inflater->size);
+			if (count < 0 && errno == EINTR)
+				continue;
+			if (count <= 0)
+				return count;
+			stream->next_in = inflater->data;
+			stream->avail_in = (uInt)count;
+		}
+		int result = inflate(stream, Z_SYNC_FLUSH);
+		long produced = length - stream->avail_out;
+		if (result == Z_STREAM_END)
+			return produced;
+		if (result != Z_OK && result != Z_BUF_ERROR) {
+			INDIGO_ERROR(indigo_error("inflate() failed (%s)", stream->msg ? stream->msg : "unknown error"));
+			return -1;
+		}
+		if (produced > 0)
+			return produced;
+	}
+}
+
+void indigo_release_inflater(indigo_inflater *inflater) {
+	assert(inflater != NULL);
+	inflateEnd(&inflater->stream);
+	free(inflater->data);
+	free(inflater);
+}
+
+static __thread indigo_shared_output *shared_outputs = NULL;
+static pthread_key_t released_shared_outputs_key;
+static pthread_once_t released_shared_outputs_once = PTHREAD_ONCE_INIT;
+static __thread unsigned long shared_output_serial = 0;
+static __thread unsigned long shared_output_last_serial = 0;
+
+static void free_shared_outputs(void *data) {
+	indigo_shared_output *shared_output = data;
+	while (shared_output != NULL) {
+		indigo_shared_output *next = shared_output->next;
+		free(shared_output);
+		shared_output = next;
+	}
+}
+
+static void create_released_shared_outputs_key() {
+	pthread_key_create(&released_shared_outputs_key, free_shared_outputs);
+}
+
+unsigned long indigo_begin_shared_output(bool shared) {
+	unsigned long previous = shared_output_serial;
+	/* serial 0 disables sharing, also for enclosing scope */
+	shared_output_serial = shared ? ++shared_output_last_serial : 0;
+	return previous;
+}
+
+void indigo_end_shared_output(unsigned long previous) {
+	pthread_once(&released_shared_outputs_once, create_released_shared_outputs_key);
+	indigo_shared_output *released_shared_outputs = pthread_getspecific(released_shared_outputs_key);
+	indigo_shared_output **pnt = &shared_outputs;
+	while (*pnt != NULL) {
+		indigo_shared_output *shared_output = *pnt;
+		if (shared_output->serial == shared_output_serial) {
+			*pnt = shared_output->next;
+			if (shared_output->buffer != NULL)
+				indigo_release_output_buffer(shared_output->buffer);
+			/* kept for next broadcast, so updates don't allocate */
+			shared_output->next = released_shared_outputs;
+			released_shared_outputs = shared_output;
+		} else {
+			pnt = &shared_output->next;
+		}
+	}
+	pthread_setspecific(released_shared_outputs_key, released_shared_outputs);
+	shared_output_serial = previous;
+}
+
+indigo_shared_output *indigo_get_shared_output(void *property, long key) {
+	if (shared_output_serial == 0)
+		return NULL;
+	for (indigo_shared_output *shared_output = shared_outputs; shared_output != NULL; shared_output = shared_output->next) {
+		if (shared_output->property == property && shared_output->key == key && shared_output->serial == shared_output_serial) {
+			shared_output->uses++;
+			return shared_output;
+		}
+	}
+	pthread_once(&released_shared_outputs_once, create_released_shared_outputs_key);
+	indigo_shared_output *shared_output = pthread_getspecific(released_shared_outputs_key);
+	if (shared_output != NULL) {
+		pthread_setspecific(released_shared_outputs_key, shared_output->next);
+	} else {
+		shared_output = malloc(sizeof(indigo_shared_output));
+		assert(shared_output != NULL);
+	}
+	shared_output->property = property;
+	shared_output->key = key;
+	shared_output->serial = shared_output_serial;
+	shared_output->uses = 1;
+	shared_output->buffer = NULL;
+	shared_output->next = shared_outputs;
+	shared_outputs = shared_output;
+	return shared_output;
+}
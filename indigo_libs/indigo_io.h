@@ -54,4 +54,87 @@ extern bool indigo_write(int handle, const char *buffer, long length);
  */
 extern bool indigo_printf(int handle, const char *format, ...);
 
+/** Growable per-connection output buffer.
+ Messages are collected in the buffer and written by indigo_buffer_flush() with a single system call.
+ */
+typedef struct indigo_output_buffer {
+	int handle;                         ///< output handle
+	char *data;                         ///< pending output
+	long length;                        ///< pending output length
+	long size;                          ///< allocated size
+	bool corked;                        ///< burst in progress, flush only when buffer is full
+	struct indigo_deflater *deflater;   ///< output compression (NULL if output is not compressed)
+} indigo_output_buffer;
+
+/** Create output buffer for handle (memory only buffer, which is never written, is created for negative handle).
+ */
+extern indigo_output_buffer *indigo_create_output_buffer(int handle);
+
+/** Flush and release output buffer.
+ */
+extern void indigo_release_output_buffer(indigo_output_buffer *buffer);
+
+/** Reserve space for length bytes at the end of output buffer and return pointer to it (caller is responsible for updating length).
+ */
+extern char *indigo_buffer_reserve(indigo_output_buffer *buffer, long length);
+
+/** Append data to output buffer (large blocks are written directly together with pending output).
+ */
+extern bool indigo_buffer_write(indigo_output_buffer *buffer, const char *data, long length);
+
+/** Append formatted data to output buffer.
+ */
+extern bool indigo_buffer_printf(indigo_output_buffer *buffer, const char *format, ...);
+
+/** Write pending output (postponed until indigo_buffer_cork(buffer, false) is called during burst).
+ */
+extern bool indigo_buffer_flush(indigo_output_buffer *buffer);
+
+/** Start or finish burst of messages (TCP_CORK/TCP_NOPUSH is applied to socket handles).
+ */
+extern bool indigo_buffer_cork(indigo_output_buffer *buffer, bool cork);
+
+/** Compress all following output as single raw deflate stream synchronized (Z_SYNC_FLUSH) on each write, pending output is written uncompressed first.
+ */
+extern bool indigo_buffer_compress(indigo_output_buffer *buffer);
+
+/** Decompression state of raw deflate input stream.
+ */
+typedef struct indigo_inflater indigo_inflater;
+
+/** Create decompression state, data already read from input handle are decompressed first.
+ */
+extern indigo_inflater *indigo_create_inflater(const char *data, long length);
+
+/** Read and decompress up to length bytes (at least one byte is returned unless end of stream or error is reached).
+ */
+extern long indigo_inflater_read(indigo_inflater *inflater, int handle, char *buffer, long length);
+
+/** Release decompression state.
+ */
+extern void indigo_release_inflater(indigo_inflater *inflater);
+
+/** Output shared by wire protocol adapters while single property update is broadcasted to clients (e.g. serialized message or encoded BLOB).
+ */
+typedef struct indigo_shared_output {
+	void *property;                     ///< property
+	long key;                           ///< adapter specific key (wire protocol dialect, version, item, ...)
+	unsigned long serial;               ///< broadcast serial number
+	int uses;                           ///< number of requests during broadcast
+	indigo_output_buffer *buffer;       ///< shared output (memory only buffer)
+	struct indigo_shared_output *next;  ///< next shared output
+} indigo_shared_output;
+
+/** Start broadcast scope for shared output (nothing is shared in the scope if shared is false), returns serial of enclosing scope.
+ */
+extern unsigned long indigo_begin_shared_output(bool shared);
+
+/** Finish broadcast scope and release shared output created in it.
+ */
+extern void indigo_end_shared_output(unsigned long previous);
+
+/** Get (or create empty) shared output for property and key, NULL is returned outside of broadcast scope.
+ */
+extern indigo_shared_output *indigo_get_shared_output(void *property, long key);
+
 #endif /* indigo_io_h */
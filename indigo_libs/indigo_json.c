@@ -32,9 +32,13 @@
 #include <pthread.h>
 #include <assert.h>
 #include <stdint.h>
+#include <stddef.h>
+#include <errno.h>
 #include <arpa/inet.h>
+#include <zlib.h>
 
 #include "indigo_json.h"
+#include "indigo_dtoa.h"
 #include "indigo_io.h"
 
 //#undef INDIGO_TRACE_PROTOCOL
@@ -45,32 +49,401 @@
 
 #define PROPERTY_SIZE sizeof(indigo_property)+INDIGO_MAX_ITEMS*(sizeof(indigo_item))
 
-static long ws_read(int handle, char *buffer, long length) {
-	uint8_t header[14];
-	if (indigo_read(handle, (char *)header, 6) <= 0)
-		return -1;
-	INDIGO_TRACE_PROTOCOL(indigo_trace("ws_read -> %2x", header[0]));
-	uint8_t *masking_key = header+2;
+#define WS_CONTINUATION_FRAME 0x0
+#define WS_TEXT_FRAME 0x1
+#define WS_BINARY_FRAME 0x2
+#define WS_CLOSE_FRAME 0x8
+#define WS_PING_FRAME 0x9
+#define WS_PONG_FRAME 0xA
+
+/* permessage-deflate (RFC7692) state, compressor window and memory level are kept small to limit memory used by each session */
+
+#define WS_DEFLATE_WINDOW_BITS	12
+#define WS_DEFLATE_MEM_LEVEL		5
+
+struct indigo_ws_compression {
+	z_stream deflate;
+	z_stream inflate;
+	bool no_context_takeover;
+	char *buffer;
+	long buffer_size;
+};
+
+static int parse_window_bits(const char *value, int min) {
+	if (value == NULL)
+		return 0;
+	if (*value == '"')
+		value++;
+	int bits = atoi(value);
+	return bits >= min && bits <= 15 ? bits : 0;
+}
+
+indigo_ws_compression *indigo_ws_compression_negotiate(const char *offer, char *response, int response_size) {
+	char offers[INDIGO_VALUE_SIZE];
+	strncpy(offers, offer, sizeof(offers) - 1);
+	offers[sizeof(offers) - 1] = 0;
+	char *last_offer;
+	for (char *extension = strtok_r(offers, ",", &last_offer); extension; extension = strtok_r(NULL, ",", &last_offer)) {
+		char *last_param;
+		char *param = strtok_r(extension, "; \t", &last_param);
+		if (param == NULL || strcmp(param, "permessage-deflate"))
+			continue;
+		int server_window_bits = WS_DEFLATE_WINDOW_BITS, client_window_bits = 15;
+		bool server_no_context_takeover = false, client_no_context_takeover = false, server_max_window_bits = false, client_max_window_bits = false;
+		bool valid = true;
+		while (valid && (param = strtok_r(NULL, "; \t", &last_param))) {
+			char *value = strchr(param, '=');
+			if (value)
+				*value++ = 0;
+			if (!strcmp(param, "server_no_context_takeover")) {
+				server_no_context_takeover = true;
+			} else if (!strcmp(param, "client_no_context_takeover")) {
+				client_no_context_takeover = true;
+			} else if (!strcmp(param, "server_max_window_bits")) {
+				/* zlib can't produce raw deflate stream with 256 bytes window */
+				int bits = parse_window_bits(value, 9);
+				if (bits == 0)
+					valid = false;
+				else if (bits < server_window_bits)
+					server_window_bits = bits;
+				server_max_window_bits = true;
+			} else if (!strcmp(param, "client_max_window_bits")) {
+				int bits = value ? parse_window_bits(value, 8) : 15;
+				if (bits == 0)
+					valid = false;
+				else
+					client_window_bits = bits < WS_DEFLATE_WINDOW_BITS ? bits : WS_DEFLATE_WINDOW_BITS;
+				client_max_window_bits = true;
+			} else {
+				valid = false;
+			}
+		}
+		if (!valid)
+			continue;
+		indigo_ws_compression *compression = malloc(sizeof(indigo_ws_compression));
+		assert(compression != NULL);
+		memset(compression, 0, sizeof(indigo_ws_compression));
+		if (deflateInit2(&compression->deflate, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -server_window_bits, WS_DEFLATE_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK) {
+			free(compression);
+			return NULL;
+		}
+		if (inflateInit2(&compression->inflate, -client_window_bits) != Z_OK) {
+			deflateEnd(&compression->deflate);
+			free(compression);
+			return NULL;
+		}
+		compression->no_context_takeover = server_no_context_takeover;
+		int size = snprintf(response, response_size, "permessage-deflate");
+		if (server_no_context_takeover)
+			size += snprintf(response + size, response_size - size, "; server_no_context_takeover");
+		if (client_no_context_takeover)
+			size += snprintf(response + size, response_size - size, "; client_no_context_takeover");
+		if (server_max_window_bits)
+			size += snprintf(response + size, response_size - size, "; server_max_window_bits=%d", server_window_bits);
+		if (client_max_window_bits)
+			size += snprintf(response + size, response_size - size, "; client_max_window_bits=%d", client_window_bits);
+		INDIGO_DEBUG_PROTOCOL(indigo_debug("WebSocket extension negotiated: %s", response));
+		return compression;
+	}
+	return NULL;
+}
+
+long indigo_ws_compress(indigo_ws_compression *compression, const char *data, long length, const char **output) {
+	z_stream *stream = &compression->deflate;
+	stream->next_in = (Bytef *)data;
+	stream->avail_in = (uInt)length;
+	long size = 0;
+	do {
+		if (compression->buffer_size - size < 64) {
+			compression->buffer_size = compression->buffer_size ? 2 * compression->buffer_size : deflateBound(stream, length) + 64;
+			compression->buffer = realloc(compression->buffer, compression->buffer_size);
+			assert(compression->buffer != NULL);
+		}
+		stream->next_out = (Bytef *)compression->buffer + size;
+		stream->avail_out = (uInt)(compression->buffer_size - size);
+		deflate(stream, Z_SYNC_FLUSH);
+		size = compression->buffer_size - stream->avail_out;
+	} while (stream->avail_out == 0);
+	if (compression->no_context_takeover)
+		deflateReset(stream);
+	*output = compression->buffer;
+	/* empty stored block terminating each message is implied */
+	return size - 4;
+}
+
+void indigo_ws_compression_release(indigo_ws_compression *compression) {
+	if (compression == NULL)
+		return;
+	deflateEnd(&compression->deflate);
+	inflateEnd(&compression->inflate);
+	free(compression->buffer);
+	free(compression);
+}
+
+/* JSON string escaping, quote, backslash and control characters are escaped, UTF-8 is passed through */
+
+static inline const char *scan_json_escape(const char *pointer) {
+	unsigned char c;
+	while ((c = *pointer) >= 0x20 && c != '"' && c != '\\')
+		pointer++;
+	return pointer;
+}
+
+bool indigo_buffer_json_escape(indigo_output_buffer *buffer, const char *string) {
+	bool result = true;
+	while (true) {
+		const char *end = scan_json_escape(string);
+		if (end > string)
+			result = indigo_buffer_write(buffer, string, end - string) && result;
+		if (*end == 0)
+			return result;
+		char escape[8] = { '\\', *end };
+		int length = 2;
+		switch (*end) {
+			case '\b':
+				escape[1] = 'b';
+				break;
+			case '\f':
+				escape[1] = 'f';
+				break;
+			case '\n':
+				escape[1] = 'n';
+				break;
+			case '\r':
+				escape[1] = 'r';
+				break;
+			case '\t':
+				escape[1] = 't';
+				break;
+			case '"':
+			case '\\':
+				break;
+			default:
+				length = sprintf(escape, "\\u%04x", (unsigned char)*end);
+				break;
+		}
+		result = indigo_buffer_write(buffer, escape, length) && result;
+		string = end + 1;
+	}
+}
+
+static int utf8_encode(char *output, unsigned code) {
+	if (code < 0x80) {
+		output[0] = code;
+		return 1;
+	}
+	if (code < 0x800) {
+		output[0] = 0xC0 | (code >> 6);
+		output[1] = 0x80 | (code & 0x3F);
+		return 2;
+	}
+	if (code < 0x10000) {
+		output[0] = 0xE0 | (code >> 12);
+		output[1] = 0x80 | ((code >> 6) & 0x3F);
+		output[2] = 0x80 | (code & 0x3F);
+		return 3;
+	}
+	output[0] = 0xF0 | (code >> 18);
+	output[1] = 0x80 | ((code >> 12) & 0x3F);
+	output[2] = 0x80 | ((code >> 6) & 0x3F);
+	output[3] = 0x80 | (code & 0x3F);
+	return 4;
+}
+
+/* Buffered input, many messages or frames are consumed per read() */
+
+typedef struct {
+	indigo_adapter_context *context;
+	long start, end;                    /* unprocessed input */
+	uint64_t remains;                   /* unread payload of current WebSocket data frame */
+	uint8_t mask[4];                    /* masking key of current frame */
+	int mask_offset;                    /* position of unread payload in masking key */
+	bool skip;                          /* payload of current message is ignored (binary message) */
+	bool fin;                           /* current frame is the last frame of message */
+	bool compressed;                    /* payload of current message is compressed (permessage-deflate) */
+	bool flushed;                       /* end of compressed message was passed to inflate */
+	bool inflate_pending;               /* inflate may have more output for already consumed input */
+	char data[JSON_BUFFER_SIZE];
+} input_reader;
+
+static bool fill(input_reader *reader, long needed) {
+	if (reader->end - reader->start >= needed)
+		return true;
+	if (reader->start + needed > JSON_BUFFER_SIZE) {
+		memmove(reader->data, reader->data + reader->start, reader->end - reader->start);
+		reader->end -= reader->start;
+		reader->start = 0;
+	}
+	while (reader->end - reader->start < needed) {
+		ssize_t bytes_read = read(reader->context->input, reader->data + reader->end, JSON_BUFFER_SIZE - reader->end);
+		if (bytes_read < 0 && errno == EINTR)
+			continue;
+		if (bytes_read <= 0)
+			return false;
+		reader->end += bytes_read;
+	}
+	return true;
+}
+
+static void unmask(char *data, long length, uint8_t *mask, int offset) {
+	uint8_t rotated_mask[8];
+	for (int i = 0; i < 8; i++)
+		rotated_mask[i] = mask[(offset + i) & 3];
+	uint64_t mask64;
+	memcpy(&mask64, rotated_mask, 8);
+	long i = 0;
+	for (; i + 8 <= length; i += 8) {
+		uint64_t word;
+		memcpy(&word, data + i, 8);
+		word ^= mask64;
+		memcpy(data + i, &word, 8);
+	}
+	for (; i < length; i++)
+		data[i] ^= rotated_mask[i & 7];
+}
+
+static void ws_write_control(indigo_adapter_context *context, uint8_t opcode, const char *payload, long length) {
+	uint8_t header[2] = { 0x80 | opcode, length };
+	pthread_mutex_lock(&context->output_mutex);
+	indigo_write(context->output, (char *)header, 2);
+	indigo_write(context->output, payload, length);
+	pthread_mutex_unlock(&context->output_mutex);
+}
+
+static bool ws_read_frame_header(input_reader *reader) {
+	if (!fill(reader, 2))
+		return false;
+	uint8_t *header = (uint8_t *)reader->data + reader->start;
+	int header_length = 2 + ((header[1] & 0x7F) == 0x7E ? 2 : (header[1] & 0x7F) == 0x7F ? 8 : 0) + (header[1] & 0x80 ? 4 : 0);
+	if (!fill(reader, header_length))
+		return false;
+	header = (uint8_t *)reader->data + reader->start;
+	int opcode = header[0] & 0x0F;
 	uint64_t payload_length = header[1] & 0x7F;
+	uint8_t *masking_key = header + 2;
 	if (payload_length == 0x7E) {
-		if (indigo_read(handle, (char *)header + 6, 2) <= 0)
-			return -1;
+		uint16_t length16;
+		memcpy(&length16, header + 2, 2);
+		payload_length = ntohs(length16);
 		masking_key = header + 4;
-		payload_length = ntohs(*((uint16_t *)(header+2)));
 	} else if (payload_length == 0x7F) {
-		if (indigo_read(handle, (char *)header + 6, 8) <= 0)
-			return -1;
-		masking_key = header+10;
-		payload_length = ntohll(*((uint64_t *)(header+2)));
+		uint64_t length64;
+		memcpy(&length64, header + 2, 8);
+		payload_length = ntohll(length64);
+		masking_key = header + 10;
 	}
-	if (length < payload_length)
-		return -1;
-	if (indigo_read(handle, buffer, payload_length) <= 0)
-		return -1;
-	for (uint64_t i = 0; i < payload_length; i++) {
-		buffer[i] ^= masking_key[i%4];
+	if (header[1] & 0x80)
+		memcpy(reader->mask, masking_key, 4);
+	else
+		memset(reader->mask, 0, 4);
+	reader->start += header_length;
+	INDIGO_TRACE_PROTOCOL(indigo_trace("ws_read -> %2x %llu", header[0], (unsigned long long)payload_length));
+	if (opcode >= WS_CLOSE_FRAME) {
+		/* control frames are never fragmented and can be interleaved with fragmented message */
+		if (payload_length > 0x7D || !fill(reader, payload_length))
+			return false;
+		char *payload = reader->data + reader->start;
+		unmask(payload, payload_length, reader->mask, 0);
+		reader->start += payload_length;
+		if (opcode == WS_PING_FRAME) {
+			ws_write_control(reader->context, WS_PONG_FRAME, payload, payload_length);
+		} else if (opcode == WS_CLOSE_FRAME) {
+			ws_write_control(reader->context, WS_CLOSE_FRAME, payload, payload_length < 2 ? payload_length : 2);
+			return false;
+		}
+		return true;
+	}
+	if (opcode == WS_TEXT_FRAME || opcode == WS_BINARY_FRAME) {
+		if ((header[0] & 0x40) && reader->context->compression == NULL)
+			return false;
+		reader->skip = opcode == WS_BINARY_FRAME;
+		reader->compressed = header[0] & 0x40;
+		reader->flushed = false;
+	}
+	reader->fin = header[0] & 0x80;
+	reader->remains = payload_length;
+	reader->mask_offset = 0;
+	return true;
+}
+
+/* Read next part of JSON text, WebSocket messages are unmasked and defragmented, control frames are handled */
+
+static long json_read(input_reader *reader, char *buffer, long length) {
+	if (!reader->context->web_socket) {
+		/* parser doesn't depend on message boundaries, read as much as available */
+		while (true) {
+			ssize_t bytes_read = read(reader->context->input, buffer, length);
+			if (bytes_read < 0 && errno == EINTR)
+				continue;
+			return bytes_read;
+		}
+	}
+	static uint8_t message_tail[] = { 0x00, 0x00, 0xFF, 0xFF };
+	while (true) {
+		if (reader->compressed) {
+			/* input is consumed only after inflate took everything, so fill() never moves data still referenced by next_in */
+			z_stream *stream = &reader->context->compression->inflate;
+			if (stream->avail_in > 0 || reader->inflate_pending) {
+				stream->next_out = (Bytef *)buffer;
+				stream->avail_out = (uInt)length;
+				int result = inflate(stream, Z_SYNC_FLUSH);
+				if (result == Z_STREAM_END)
+					inflateReset(stream);
+				else if (result != Z_OK && result != Z_BUF_ERROR)
+					return -1;
+				long count = length - stream->avail_out;
+				reader->inflate_pending = stream->avail_out == 0;
+				if (count > 0 && !reader->skip)
+					return count;
+				if (count == 0 && stream->avail_in > 0 && result != Z_STREAM_END)
+					return -1;
+				continue;
+			}
+			if (reader->remains == 0 && reader->fin && !reader->flushed) {
+				stream->next_in = message_tail;
+				stream->avail_in = sizeof(message_tail);
+				reader->flushed = true;
+				continue;
+			}
+		}
+		if (reader->remains == 0) {
+			if (!ws_read_frame_header(reader))
+				return -1;
+			continue;
+		}
+		if (reader->start == reader->end) {
+			reader->start = reader->end = 0;
+			if (!fill(reader, 1))
+				return -1;
+		}
+		long count = reader->end - reader->start;
+		if ((uint64_t)count > reader->remains)
+			count = reader->remains;
+		if (reader->compressed) {
+			char *payload = reader->data + reader->start;
+			unmask(payload, count, reader->mask, reader->mask_offset);
+			reader->mask_offset = (reader->mask_offset + count) & 3;
+			reader->start += count;
+			reader->remains -= count;
+			z_stream *stream = &reader->context->compression->inflate;
+			stream->next_in = (Bytef *)payload;
+			stream->avail_in = (uInt)count;
+			continue;
+		}
+		if (reader->skip) {
+			reader->start += count;
+			reader->remains -= count;
+			continue;
+		}
+		if (count > length)
+			count = length;
+		memcpy(buffer, reader->data + reader->start, count);
+		unmask(buffer, count, reader->mask, reader->mask_offset);
+		reader->mask_offset = (reader->mask_offset + count) & 3;
+		reader->start += count;
+		reader->remains -= count;
+		return count;
 	}
-	return payload_length;
 }
 
 typedef enum {
@@ -87,7 +460,9 @@ typedef enum {
 	VALUE2,
 	END_STRUCT,
 	BEGIN_ARRAY,
-	END_ARRAY
+	END_ARRAY,
+	TEXT_ESCAPE,
+	TEXT_UNICODE
 } parser_state;
 
 
@@ -105,11 +480,20 @@ static char *parser_state_name[] = {
 	"VALUE2",
 	"END_STRUCT",
 	"BEGIN_ARRAY",
-	"END_ARRAY"
+	"END_ARRAY",
+	"TEXT_ESCAPE",
+	"TEXT_UNICODE"
 };
 
 typedef void *(* parser_handler)(parser_state state, char *name, char *value, indigo_property *property, indigo_device *device, indigo_client *client, char *message);
 
+/* Clear only items touched by the last message, untouched part of property buffer is still zeroed */
+
+static inline void clear_property_buffer(indigo_property *property) {
+	int count = property->count < INDIGO_MAX_ITEMS ? property->count + 1 : INDIGO_MAX_ITEMS;
+	memset(property, 0, sizeof(indigo_property) + count * sizeof(indigo_item));
+}
+
 static void *top_level_handler(parser_state state, char *name, char *value, indigo_property *property, indigo_device *device, indigo_client *client, char *message);
 static void *new_text_vector_handler(parser_state state, char *name, char *value, indigo_property *property, indigo_device *device, indigo_client *client, char *message);
 static void *new_number_vector_handler(parser_state state, char *name, char *value, indigo_property *property, indigo_device *device, indigo_client *client, char *message);
@@ -126,6 +510,25 @@ static void *get_properties_handler(parser_state state, char *name, char *value,
 	return get_properties_handler;
 }
 
+static void *enable_blob_handler(parser_state state, char *name, char *value, indigo_property *property, indigo_device *device, indigo_client *client, char *message) {
+	INDIGO_TRACE_PROTOCOL(indigo_trace("JSON Parser: %s %s '%s' '%s'", __FUNCTION__, parser_state_name[state], name != NULL ? name : "", value != NULL ? value : ""));
+	if (state == TEXT_VALUE && !strcmp(name, "value")) {
+		if (!strcmp(value, "Also")) {
+			client->enable_blob = INDIGO_ENABLE_BLOB_ALSO;
+		} else if (!strcmp(value, "Never")) {
+			client->enable_blob = INDIGO_ENABLE_BLOB_NEVER;
+		} else if (!strcmp(value, "Only")) {
+			client->enable_blob = INDIGO_ENABLE_BLOB_ONLY;
+		} else if (!strcmp(value, "URL")) {
+			client->enable_blob = INDIGO_ENABLE_BLOB_URL;
+		}
+		INDIGO_DEBUG(indigo_debug("BLOB mode is '%s'", value));
+	} else if (state == END_STRUCT) {
+		return top_level_handler;
+	}
+	return enable_blob_handler;
+}
+
 static void *one_text_handler(parser_state state, char *name, char *value, indigo_property *property, indigo_device *device, indigo_client *client, char *message) {
 	INDIGO_TRACE_PROTOCOL(indigo_trace("JSON Parser: %s %s '%s' '%s'", __FUNCTION__, parser_state_name[state], name != NULL ? name : "", value != NULL ? value : ""));
 	if (state == END_ARRAY)
@@ -168,7 +571,7 @@ static void *one_number_handler(parser_state state, char *name, char *value, ind
 	} else if (state == TEXT_VALUE && !strcmp(name, "name")) {
 		strncpy(property->items[property->count].name, value, INDIGO_NAME_SIZE);
 	} else if (state == NUMBER_VALUE && !strcmp(name, "value")) {
-		property->items[property->count].number.value = atof(value);
+		property->items[property->count].number.value = indigo_atof(value);
 	}
 	return one_number_handler;
 }
@@ -228,10 +631,12 @@ static void *new_switch_vector_handler(parser_state state, char *name, char *val
 static void *top_level_handler(parser_state state, char *name, char *value, indigo_property *property, indigo_device *device, indigo_client *client, char *message) {
 	INDIGO_TRACE_PROTOCOL(indigo_trace("JSON Parser: %s %s '%s' '%s'", __FUNCTION__, parser_state_name[state], name != NULL ? name : "", value != NULL ? value : ""));
 	if (state == BEGIN_STRUCT) {
-		memset(property, 0, PROPERTY_SIZE);
+		clear_property_buffer(property);
 		if (name != NULL) {
 			if (!strcmp(name, "getProperties"))
 				return get_properties_handler;
+			if (!strcmp(name, "enableBLOB"))
+				return enable_blob_handler;
 			if (!strcmp(name, "newTextVector")) {
 				property->type = INDIGO_TEXT_VECTOR;
 				property->version = client->version;
@@ -255,6 +660,10 @@ static void *top_level_handler(parser_state state, char *name, char *value, indi
 void indigo_json_parse(indigo_device *device, indigo_client *client) {
 	indigo_adapter_context *context = (indigo_adapter_context*)client->client_context;
 	int handle = context->input;
+	input_reader *reader = malloc(sizeof(input_reader));
+	assert(reader != NULL);
+	memset(reader, 0, offsetof(input_reader, data));
+	reader->context = context;
 	char buffer[JSON_BUFFER_SIZE];
 	char *pointer = buffer;
 	char *buffer_end = NULL;
@@ -267,6 +676,8 @@ void indigo_json_parse(indigo_device *device, indigo_client *client) {
 	*pointer = 0;
 	char c = 0;
 	char q = '"';
+	unsigned unicode = 0, high_surrogate = 0;
+	int unicode_digits = 0;
 	int depth = 0;
 	parser_handler handler = top_level_handler;
 	parser_state state = IDLE;
@@ -281,7 +692,7 @@ void indigo_json_parse(indigo_device *device, indigo_client *client) {
 			goto exit_loop;
 		}
 		while ((c = *pointer++) == 0) {
-			ssize_t count = (int)context->web_socket ? ws_read(handle, buffer, JSON_BUFFER_SIZE) : indigo_read_line(handle, buffer, JSON_BUFFER_SIZE);
+			ssize_t count = json_read(reader, buffer, JSON_BUFFER_SIZE - 1);
 			if (count <= 0) {
 				goto exit_loop;
 			}
@@ -380,6 +791,8 @@ void indigo_json_parse(indigo_device *device, indigo_client *client) {
 					*value_pointer = 0;
 					handler = handler(TEXT_VALUE, name_buffer, value_buffer, property, device, client, message);
 					INDIGO_TRACE_PROTOCOL(indigo_trace("JSON Parser: '%c' TEXT_VALUE -> VALUE1", c));
+				} else if (c == '\\') {
+					state = TEXT_ESCAPE;
 				} else if (value_pointer - value_buffer <INDIGO_VALUE_SIZE) {
 					*value_pointer++ = c;
 				} else {
@@ -387,8 +800,65 @@ void indigo_json_parse(indigo_device *device, indigo_client *client) {
 					INDIGO_TRACE_PROTOCOL(indigo_trace("JSON Parser: '%c' TEXT_VALUE -> ERROR", c));
 				}
 				break;
+			case TEXT_ESCAPE:
+				state = TEXT_VALUE;
+				switch (c) {
+					case 'b':
+						c = '\b';
+						break;
+					case 'f':
+						c = '\f';
+						break;
+					case 'n':
+						c = '\n';
+						break;
+					case 'r':
+						c = '\r';
+						break;
+					case 't':
+						c = '\t';
+						break;
+					case 'u':
+						state = TEXT_UNICODE;
+						unicode = 0;
+						unicode_digits = 0;
+						break;
+				}
+				if (state == TEXT_UNICODE) {
+				} else if (value_pointer - value_buffer < INDIGO_VALUE_SIZE - 1) {
+					*value_pointer++ = c;
+				} else {
+					state = ERROR;
+					INDIGO_TRACE_PROTOCOL(indigo_trace("JSON Parser: '%c' TEXT_ESCAPE -> ERROR", c));
+				}
+				break;
+			case TEXT_UNICODE:
+				if (!isxdigit(c)) {
+					state = ERROR;
+					INDIGO_TRACE_PROTOCOL(indigo_trace("JSON Parser: '%c' TEXT_UNICODE -> ERROR", c));
+					break;
+				}
+				unicode = (unicode << 4) | (isdigit(c) ? c - '0' : tolower(c) - 'a' + 10);
+				if (++unicode_digits < 4)
+					break;
+				state = TEXT_VALUE;
+				if (unicode >= 0xD800 && unicode < 0xDC00) {
+					/* high surrogate is combined with following \uDCxx */
+					high_surrogate = unicode;
+					break;
+				}
+				if (unicode >= 0xDC00 && unicode < 0xE000 && high_surrogate)
+					unicode = 0x10000 + ((high_surrogate - 0xD800) << 10) + (unicode - 0xDC00);
+				high_surrogate = 0;
+				if (value_pointer - value_buffer < INDIGO_VALUE_SIZE - 4) {
+					value_pointer += utf8_encode(value_pointer, unicode);
+				} else {
+					state = ERROR;
+					INDIGO_TRACE_PROTOCOL(indigo_trace("JSON Parser: '%c' TEXT_UNICODE -> ERROR", c));
+				}
+				break;
 			case NUMBER_VALUE:
-				if ((isdigit(c) || c == '.') && value_pointer - value_buffer <INDIGO_VALUE_SIZE) {
+				if ((isdigit(c) || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') && value_pointer - value_buffer <INDIGO_VALUE_SIZE) {
 					*value_pointer++ = c;
 				} else {
 					state = VALUE1;
@@ -458,6 +928,7 @@ void indigo_json_parse(indigo_device *device, indigo_client *client) {
 		}
 	}
 exit_loop:
+	free(reader);
 	close(handle);
 	indigo_log("JSON Parser: parser finished");
 }
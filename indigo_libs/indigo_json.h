@@ -28,6 +28,7 @@
 
 #include <stdio.h>
 #include "indigo_bus.h"
+#include "indigo_io.h"
 
 #define JSON_BUFFER_SIZE	(64 * 1024)
 
@@ -39,6 +40,26 @@
 #define ntohll(x) ((1==ntohl(1)) ? (x) : ((uint64_t)ntohl((x) & 0xFFFFFFFF) << 32) | ntohl((x) >> 32))
 #endif
 
+/** Append JSON escaped string to output buffer.
+ */
+extern bool indigo_buffer_json_escape(indigo_output_buffer *buffer, const char *string);
+
+/** WebSocket permessage-deflate extension (RFC7692) state.
+ */
+typedef struct indigo_ws_compression indigo_ws_compression;
+
+/** Negotiate permessage-deflate extension from Sec-WebSocket-Extensions request header, parameters of accepted offer are stored to response.
+ */
+extern indigo_ws_compression *indigo_ws_compression_negotiate(const char *offer, char *response, int response_size);
+
+/** Compress WebSocket message payload, compressed data are valid until next call.
+ */
+extern long indigo_ws_compress(indigo_ws_compression *compression, const char *data, long length, const char **output);
+
+/** Release permessage-deflate extension state.
+ */
+extern void indigo_ws_compression_release(indigo_ws_compression *compression);
+
 /** JSON wire protocol parser.
  */
 extern void indigo_json_parse(indigo_device *device, indigo_client *client);
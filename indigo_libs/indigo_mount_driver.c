@@ -36,6 +36,7 @@
 
 #include "indigo_mount_driver.h"
 #include "indigo_io.h"
+#include "indigo_dtoa.h"
 
 indigo_result indigo_mount_attach(indigo_device *device, unsigned version) {
 	assert(device != NULL);
@@ -334,7 +335,12 @@ indigo_result indigo_mount_change_property(indigo_device *device, indigo_client
 				indigo_printf(handle, "%d\n", count);
 				for (int i = 0; i < count; i++) {
 					indigo_alignment_point *point =  MOUNT_CONTEXT->alignment_points + i;
-					indigo_printf(handle, "%d %g %g %g %g\n", point->used, point->ra, point->dec, point->raw_ra, point->raw_dec);
+					char ra[INDIGO_DTOA_SIZE], dec[INDIGO_DTOA_SIZE], raw_ra[INDIGO_DTOA_SIZE], raw_dec[INDIGO_DTOA_SIZE];
+					indigo_dtoa(point->ra, ra);
+					indigo_dtoa(point->dec, dec);
+					indigo_dtoa(point->raw_ra, raw_ra);
+					indigo_dtoa(point->raw_dec, raw_dec);
+					indigo_printf(handle, "%d %s %s %s %s\n", point->used, ra, dec, raw_ra, raw_dec);
 				}
 				close(handle);
 			}
@@ -351,7 +357,12 @@ indigo_result indigo_mount_change_property(indigo_device *device, indigo_client
 				for (int i = 0; i < count; i++) {
 					indigo_alignment_point *point =  MOUNT_CONTEXT->alignment_points + i;
 					indigo_read_line(handle, buffer, sizeof(buffer));
-					sscanf(buffer, "%d %lg %lg %lg %lg", (int *)&point->used, &point->ra, &point->dec, &point->raw_ra, &point->raw_dec);
+					char *pnt;
+					point->used = strtol(buffer, &pnt, 10) != 0;
+					point->ra = indigo_strtod(pnt, &pnt);
+					point->dec = indigo_strtod(pnt, &pnt);
+					point->raw_ra = indigo_strtod(pnt, &pnt);
+					point->raw_dec = indigo_strtod(pnt, &pnt);
 					snprintf(name, INDIGO_NAME_SIZE, "%d", i);
 					snprintf(label, INDIGO_VALUE_SIZE, "RA %.2f / Dec %.2f", point->ra, point->dec);
 					indigo_init_switch_item(MOUNT_ALIGNMENT_SELECT_POINTS_PROPERTY->items + i, name, label, point->used);
@@ -394,13 +405,13 @@ indigo_result indigo_mount_change_property(indigo_device *device, indigo_client
 				}
 				MOUNT_ALIGNMENT_SELECT_POINTS_PROPERTY->count = MOUNT_CONTEXT->alignment_point_count;
 				MOUNT_ALIGNMENT_SELECT_POINTS_PROPERTY->state = INDIGO_OK_STATE;
-				indigo_delete_property(device, MOUNT_ALIGNMENT_SELECT_POINTS_PROPERTY, NULL);
-				indigo_define_property(device, MOUNT_ALIGNMENT_SELECT_POINTS_PROPERTY, NULL);
+				indigo_define_property_items(device, MOUNT_ALIGNMENT_SELECT_POINTS_PROPERTY, index, 1, NULL);
+				if (MOUNT_ALIGNMENT_MODE_SINGLE_POINT_ITEM->sw.value)
+					indigo_update_property(device, MOUNT_ALIGNMENT_SELECT_POINTS_PROPERTY, NULL);
 				indigo_init_switch_item(MOUNT_ALIGNMENT_DELETE_POINTS_PROPERTY->items + index, name, label, false);
 				MOUNT_ALIGNMENT_DELETE_POINTS_PROPERTY->count = MOUNT_CONTEXT->alignment_point_count;
 				MOUNT_ALIGNMENT_DELETE_POINTS_PROPERTY->state = INDIGO_OK_STATE;
-				indigo_delete_property(device, MOUNT_ALIGNMENT_DELETE_POINTS_PROPERTY, NULL);
-				indigo_define_property(device, MOUNT_ALIGNMENT_DELETE_POINTS_PROPERTY, NULL);
+				indigo_define_property_items(device, MOUNT_ALIGNMENT_DELETE_POINTS_PROPERTY, index, 1, NULL);
 				MOUNT_EQUATORIAL_COORDINATES_PROPERTY->state = INDIGO_OK_STATE;
 				indigo_update_property(device, MOUNT_EQUATORIAL_COORDINATES_PROPERTY, NULL);
 			}
@@ -456,6 +467,7 @@ indigo_result indigo_mount_change_property(indigo_device *device, indigo_client
 		return INDIGO_OK;
 	} else if (indigo_property_match(MOUNT_ALIGNMENT_DELETE_POINTS_PROPERTY, property)) {
 		// -------------------------------------------------------------------------------- MOUNT_ALIGNMENT_DELETE_POINTS
+		int first = MOUNT_CONTEXT->alignment_point_count;
 		for (int i = 0; i < property->count; i++) {
 			int index = atoi(property->items[i].name);
 			if (index < MOUNT_CONTEXT->alignment_point_count) {
@@ -469,7 +481,9 @@ indigo_result indigo_mount_change_property(indigo_device *device, indigo_client
 						MOUNT_ALIGNMENT_DELETE_POINTS_PROPERTY->items[j - 1] = MOUNT_ALIGNMENT_DELETE_POINTS_PROPERTY->items[j];
 						strcpy(MOUNT_ALIGNMENT_DELETE_POINTS_PROPERTY->items[j - 1].name, name);
 					}
-					MOUNT_ALIGNMENT_SELECT_POINTS_PROPERTY->count = MOUNT_ALIGNMENT_DELETE_POINTS_PROPERTY->count = --MOUNT_CONTEXT->alignment_point_count;
+					--MOUNT_CONTEXT->alignment_point_count;
+					if (index < first)
+						first = index;
 				}
 			}
 		}
@@ -477,12 +491,22 @@ indigo_result indigo_mount_change_property(indigo_device *device, indigo_client
 		indigo_raw_to_translated(device, MOUNT_RAW_COORDINATES_RA_ITEM->number.target, MOUNT_RAW_COORDINATES_DEC_ITEM->number.target, &MOUNT_EQUATORIAL_COORDINATES_RA_ITEM->number.target, &MOUNT_EQUATORIAL_COORDINATES_DEC_ITEM->number.target);
 		MOUNT_EQUATORIAL_COORDINATES_PROPERTY->state = INDIGO_OK_STATE;
 		indigo_update_property(device, MOUNT_EQUATORIAL_COORDINATES_PROPERTY, NULL);
-		indigo_delete_property(device, MOUNT_ALIGNMENT_SELECT_POINTS_PROPERTY, NULL);
+		int count = MOUNT_CONTEXT->alignment_point_count;
+		int removed = MOUNT_ALIGNMENT_SELECT_POINTS_PROPERTY->count - count;
 		MOUNT_ALIGNMENT_SELECT_POINTS_PROPERTY->state = INDIGO_OK_STATE;
-		indigo_define_property(device, MOUNT_ALIGNMENT_SELECT_POINTS_PROPERTY, NULL);
-		indigo_delete_property(device, MOUNT_ALIGNMENT_DELETE_POINTS_PROPERTY, NULL);
 		MOUNT_ALIGNMENT_DELETE_POINTS_PROPERTY->state = INDIGO_OK_STATE;
-		indigo_define_property(device, MOUNT_ALIGNMENT_DELETE_POINTS_PROPERTY, NULL);
+		if (removed > 0) {
+			// trailing names disappear, items from first on are renumbered
+			indigo_delete_property_items(device, MOUNT_ALIGNMENT_SELECT_POINTS_PROPERTY, count, removed, NULL);
+			indigo_delete_property_items(device, MOUNT_ALIGNMENT_DELETE_POINTS_PROPERTY, count, removed, NULL);
+			if (first < count) {
+				indigo_define_property_items(device, MOUNT_ALIGNMENT_SELECT_POINTS_PROPERTY, first, count - first, NULL);
+				indigo_define_property_items(device, MOUNT_ALIGNMENT_DELETE_POINTS_PROPERTY, first, count - first, NULL);
+			}
+		} else {
+			indigo_update_property(device, MOUNT_ALIGNMENT_SELECT_POINTS_PROPERTY, NULL);
+			indigo_update_property(device, MOUNT_ALIGNMENT_DELETE_POINTS_PROPERTY, NULL);
+		}
 		return INDIGO_OK;
 		// --------------------------------------------------------------------------------
 	}
@@ -43,6 +43,8 @@
 #include "indigo_server_tcp.h"
 #include "indigo_driver_xml.h"
 #include "indigo_driver_json.h"
+#include "indigo_driver_bin.h"
+#include "indigo_json.h"
 #include "indigo_client_xml.h"
 #include "indigo_base64.h"
 #include "indigo_io.h"
@@ -98,6 +100,14 @@ static void start_worker_thread(int *client_socket) {
 			indigo_json_parse(NULL, protocol_adapter);
 			indigo_detach_client(protocol_adapter);
 			indigo_release_json_device_adapter(protocol_adapter);
+		} else if ((unsigned char)c == INDIGO_BIN_MAGIC) {
+			INDIGO_LOG(indigo_log("Protocol switched to binary"));
+			indigo_client *protocol_adapter = indigo_bin_device_adapter(socket, socket);
+			assert(protocol_adapter != NULL);
+			indigo_attach_client(protocol_adapter);
+			indigo_bin_parse(NULL, protocol_adapter);
+			indigo_detach_client(protocol_adapter);
+			indigo_release_bin_device_adapter(protocol_adapter);
 		} else if (c == 'G') {
 			char request[BUFFER_SIZE];
 			char header[BUFFER_SIZE];
@@ -108,10 +118,16 @@ static void start_worker_thread(int *client_socket) {
 					if (space)
 						*space = 0;
 					char websocket_key[256] = "";
+					char websocket_extensions[BUFFER_SIZE] = "";
 					bool keep_alive = false;
 					while (indigo_read_line(socket, header, BUFFER_SIZE) > 0) {
 						if (!strncasecmp(header, "Sec-WebSocket-Key: ", 19))
 							strcpy(websocket_key, header + 19);
+						if (!strncasecmp(header, "Sec-WebSocket-Extensions: ", 26)) {
+							if (*websocket_extensions)
+								strncat(websocket_extensions, ",", BUFFER_SIZE - strlen(websocket_extensions) - 1);
+							strncat(websocket_extensions, header + 26, BUFFER_SIZE - strlen(websocket_extensions) - 1);
+						}
 						if (!strcasecmp(header, "Connection: keep-alive"))
 							keep_alive = true;
 					}
@@ -127,13 +143,19 @@ static void start_worker_thread(int *client_socket) {
 							indigo_printf(socket, "Connection: upgrade\r\n");
 							base64_encode((unsigned char *)websocket_key, shaHash, 20);
 							indigo_printf(socket, "Sec-WebSocket-Accept: %s\r\n", websocket_key);
+							char extension[BUFFER_SIZE];
+							indigo_ws_compression *compression = NULL;
+							if (*websocket_extensions && (compression = indigo_ws_compression_negotiate(websocket_extensions, extension, BUFFER_SIZE)))
+								indigo_printf(socket, "Sec-WebSocket-Extensions: %s\r\n", extension);
 							indigo_printf(socket, "\r\n");
-							INDIGO_LOG(indigo_log("Protocol switched to JSON-over-WebSockets"));
+							INDIGO_LOG(indigo_log("Protocol switched to JSON-over-WebSockets%s", compression ? " (compressed)" : ""));
 							indigo_client *protocol_adapter = indigo_json_device_adapter(socket, socket, true);
 							assert(protocol_adapter != NULL);
+							((indigo_adapter_context *)protocol_adapter->client_context)->compression = compression;
 							indigo_attach_client(protocol_adapter);
 							indigo_json_parse(NULL, protocol_adapter);
 							indigo_detach_client(protocol_adapter);
+							indigo_release_json_device_adapter(protocol_adapter);
 							break;
 						} else {
 							indigo_printf(socket, "HTTP/1.1 301 OK\r\n");
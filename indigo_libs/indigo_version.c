@@ -24,6 +24,7 @@
  */
 
 #include <string.h>
+#include <pthread.h>
 
 #include "indigo_version.h"
 #include "indigo_names.h"
@@ -302,16 +303,87 @@ static struct property_mapping legacy[] = {
 	NULL
 };
 
+#define PROPERTY_INDEX_SIZE	128 /* power of 2, at least twice the number of mapped properties */
+#define ITEM_INDEX_SIZE			512 /* power of 2, at least twice the number of mapped items */
+
+/* open addressing indexes of the table above for both directions (0 - current, 1 - legacy), built on first use */
+
+static struct property_mapping *property_index[2][PROPERTY_INDEX_SIZE];
+
+static struct item_index {
+	struct property_mapping *property;
+	struct item_mapping *item;
+} item_index[2][ITEM_INDEX_SIZE];
+
+static pthread_once_t index_once = PTHREAD_ONCE_INIT;
+
+static unsigned name_hash(const char *name, unsigned hash) {
+	while (*name) {
+		hash ^= (unsigned char)*name++;
+		hash *= 16777619;
+	}
+	return hash;
+}
+
+static unsigned item_hash(struct property_mapping *property_mapping, const char *name) {
+	return name_hash(name, (2166136261u ^ (unsigned)(property_mapping - legacy)) * 16777619);
+}
+
+static void build_index(void) {
+	for (struct property_mapping *property_mapping = legacy; property_mapping->legacy; property_mapping++) {
+		for (int direction = 0; direction < 2; direction++) {
+			const char *name = direction ? property_mapping->legacy : property_mapping->current;
+			unsigned slot = name_hash(name, 2166136261u) & (PROPERTY_INDEX_SIZE - 1);
+			struct property_mapping **entry;
+			while (*(entry = property_index[direction] + slot) != NULL && strcmp(direction ? (*entry)->legacy : (*entry)->current, name))
+				slot = (slot + 1) & (PROPERTY_INDEX_SIZE - 1);
+			if (*entry == NULL)
+				*entry = property_mapping;
+			for (struct item_mapping *item_mapping = property_mapping->items; item_mapping->legacy; item_mapping++) {
+				name = direction ? item_mapping->legacy : item_mapping->current;
+				slot = item_hash(property_mapping, name) & (ITEM_INDEX_SIZE - 1);
+				struct item_index *item_entry;
+				while ((item_entry = item_index[direction] + slot)->item != NULL && (item_entry->property != property_mapping || strcmp(direction ? item_entry->item->legacy : item_entry->item->current, name)))
+					slot = (slot + 1) & (ITEM_INDEX_SIZE - 1);
+				if (item_entry->item == NULL) {
+					item_entry->property = property_mapping;
+					item_entry->item = item_mapping;
+				}
+			}
+		}
+	}
+}
+
+static struct property_mapping *find_property(const char *name, bool legacy_name) {
+	pthread_once(&index_once, build_index);
+	unsigned slot = name_hash(name, 2166136261u) & (PROPERTY_INDEX_SIZE - 1);
+	struct property_mapping *property_mapping;
+	while ((property_mapping = property_index[legacy_name][slot]) != NULL) {
+		if (!strcmp(legacy_name ? property_mapping->legacy : property_mapping->current, name))
+			return property_mapping;
+		slot = (slot + 1) & (PROPERTY_INDEX_SIZE - 1);
+	}
+	return NULL;
+}
+
+static struct item_mapping *find_item(struct property_mapping *property_mapping, const char *name, bool legacy_name) {
+	unsigned slot = item_hash(property_mapping, name) & (ITEM_INDEX_SIZE - 1);
+	struct item_index *item_entry;
+	while ((item_entry = item_index[legacy_name] + slot)->item != NULL) {
+		if (item_entry->property == property_mapping && !strcmp(legacy_name ? item_entry->item->legacy : item_entry->item->current, name))
+			return item_entry->item;
+		slot = (slot + 1) & (ITEM_INDEX_SIZE - 1);
+	}
+	return NULL;
+}
+
 void indigo_copy_property_name(indigo_version version, indigo_property *property, const char *name) {
 	if (version == INDIGO_VERSION_LEGACY) {
-		struct property_mapping *property_mapping = legacy;
-		while (property_mapping->legacy) {
-			if (!strcmp(name, property_mapping->legacy)) {
-				INDIGO_DEBUG(indigo_debug("version: %s -> %s (current)", property_mapping->legacy, property_mapping->current));
-				strcpy(property->name, property_mapping->current);
-				return;
-			}
-			property_mapping++;
+		struct property_mapping *property_mapping = find_property(name, true);
+		if (property_mapping != NULL) {
+			INDIGO_DEBUG(indigo_debug("version: %s -> %s (current)", property_mapping->legacy, property_mapping->current));
+			strcpy(property->name, property_mapping->current);
+			return;
 		}
 	}
 	strncpy(property->name, name, INDIGO_NAME_SIZE);
@@ -319,22 +391,14 @@ void indigo_copy_property_name(indigo_version version, indigo_property *property
 
 void indigo_copy_item_name(indigo_version version, indigo_property *property, indigo_item *item, const char *name) {
 	if (version == INDIGO_VERSION_LEGACY) {
-		struct property_mapping *property_mapping = legacy;
-		while (property_mapping->legacy) {
-			if (!strcmp(property->name, property_mapping->current)) {
-				struct item_mapping *item_mapping = property_mapping->items;
-				while (item_mapping->legacy) {
-					if (!strcmp(name, item_mapping->legacy)) {
-						INDIGO_DEBUG(indigo_debug("version: %s.%s -> %s.%s (current)", property_mapping->legacy, item_mapping->legacy, property_mapping->current, item_mapping->current));
-						strncpy(item->name, item_mapping->current, INDIGO_NAME_SIZE);
-						return;
-					}
-					item_mapping++;
-				}
-				strncpy(item->name, name, INDIGO_NAME_SIZE);
+		struct property_mapping *property_mapping = find_property(property->name, false);
+		if (property_mapping != NULL) {
+			struct item_mapping *item_mapping = find_item(property_mapping, name, true);
+			if (item_mapping != NULL) {
+				INDIGO_DEBUG(indigo_debug("version: %s.%s -> %s.%s (current)", property_mapping->legacy, item_mapping->legacy, property_mapping->current, item_mapping->current));
+				strncpy(item->name, item_mapping->current, INDIGO_NAME_SIZE);
 				return;
 			}
-			property_mapping++;
 		}
 	}
 	strncpy(item->name, name, INDIGO_NAME_SIZE);
@@ -342,13 +406,10 @@ void indigo_copy_item_name(indigo_version version, indigo_property *property, in
 
 const char *indigo_property_name(indigo_version version, indigo_property *property) {
 	if (version == INDIGO_VERSION_LEGACY) {
-		struct property_mapping *property_mapping = legacy;
-		while (property_mapping->legacy) {
-			if (!strcmp(property->name, property_mapping->current)) {
-				INDIGO_DEBUG(indigo_debug("version: %s -> %s (legacy)", property_mapping->current, property_mapping->legacy));
-				return property_mapping->legacy;
-			}
-			property_mapping++;
+		struct property_mapping *property_mapping = find_property(property->name, false);
+		if (property_mapping != NULL) {
+			INDIGO_DEBUG(indigo_debug("version: %s -> %s (legacy)", property_mapping->current, property_mapping->legacy));
+			return property_mapping->legacy;
 		}
 	}
 	return property->name;
@@ -356,23 +417,14 @@ const char *indigo_property_name(indigo_version version, indigo_property *proper
 
 const char *indigo_item_name(indigo_version version, indigo_property *property, indigo_item *item) {
 	if (version == INDIGO_VERSION_LEGACY) {
-		struct property_mapping *property_mapping = legacy;
-		while (property_mapping->legacy) {
-			if (!strcmp(property->name, property_mapping->current)) {
-				struct item_mapping *item_mapping = property_mapping->items;
-				while (item_mapping->legacy) {
-					if (!strcmp(item->name, item_mapping->current)) {
-						INDIGO_DEBUG(indigo_debug("version: %s.%s -> %s.%s (legacy)", property_mapping->current, item_mapping->current, property_mapping->legacy, item_mapping->legacy));
-						return item_mapping->legacy;
-					}
-					item_mapping++;
-				}
-				return item->name;
+		struct property_mapping *property_mapping = find_property(property->name, false);
+		if (property_mapping != NULL) {
+			struct item_mapping *item_mapping = find_item(property_mapping, item->name, false);
+			if (item_mapping != NULL) {
+				INDIGO_DEBUG(indigo_debug("version: %s.%s -> %s.%s (legacy)", property_mapping->current, item_mapping->current, property_mapping->legacy, item_mapping->legacy));
+				return item_mapping->legacy;
 			}
-			property_mapping++;
 		}
 	}
 	return item->name;
 }
-
-
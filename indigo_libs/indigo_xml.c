@@ -26,6 +26,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <errno.h>
 #include <unistd.h>
@@ -35,13 +36,21 @@
 
 #include <fcntl.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include "indigo_base64.h"
 #include "indigo_xml.h"
+#include "indigo_dtoa.h"
 #include "indigo_io.h"
 #include "indigo_version.h"
 #include "indigo_driver_xml.h"
 
 #define BUFFER_SIZE 524288  /* BUFFER_SIZE % 4 == 0, inportant for base64 */
+#define SCAN_PADDING 16     /* scan_to() may read up to 15 bytes behind terminating \0 */
 
 #define PROPERTY_SIZE sizeof(indigo_property)+INDIGO_MAX_ITEMS*(sizeof(indigo_item))
 
@@ -86,6 +95,53 @@ static char *parser_state_name[] = {
 	"HEADER1"
 };
 
+/* Find first occurrence of c1, c2, c3 or \0 (string must be followed by SCAN_PADDING readable bytes) */
+
+/* decode complete quartets from line wrapped legacy BLOB, incomplete tail is moved to the beginning of buffer */
+static unsigned char *decode_blob_buffer(unsigned char *blob_pointer, char *value_buffer, char **value_pointer) {
+	long incomplete;
+	blob_pointer += base64_decode_fast_ws(blob_pointer, (unsigned char *)value_buffer, *value_pointer - value_buffer, &incomplete);
+	memmove(value_buffer, *value_pointer - incomplete, incomplete);
+	*value_pointer = value_buffer + incomplete;
+	return blob_pointer;
+}
+
+static inline char *scan_to(char *pointer, char c1, char c2, char c3) {
+#if defined(__SSE2__)
+	__m128i v1 = _mm_set1_epi8(c1), v2 = _mm_set1_epi8(c2), v3 = _mm_set1_epi8(c3), zero = _mm_setzero_si128();
+	while (true) {
+		__m128i data = _mm_loadu_si128((__m128i *)pointer);
+		__m128i match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(data, v1), _mm_cmpeq_epi8(data, v2)), _mm_or_si128(_mm_cmpeq_epi8(data, v3), _mm_cmpeq_epi8(data, zero)));
+		int mask = _mm_movemask_epi8(match);
+		if (mask)
+			return pointer + __builtin_ctz(mask);
+		pointer += 16;
+	}
+#elif defined(__ARM_NEON)
+	uint8x16_t v1 = vdupq_n_u8(c1), v2 = vdupq_n_u8(c2), v3 = vdupq_n_u8(c3), zero = vdupq_n_u8(0);
+	while (true) {
+		uint8x16_t data = vld1q_u8((uint8_t *)pointer);
+		uint8x16_t match = vorrq_u8(vorrq_u8(vceqq_u8(data, v1), vceqq_u8(data, v2)), vorrq_u8(vceqq_u8(data, v3), vceqq_u8(data, zero)));
+		uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(match), 4)), 0);
+		if (mask)
+			return pointer + (__builtin_ctzll(mask) >> 2);
+		pointer += 16;
+	}
+#else
+	char c;
+	while ((c = *pointer) && c != c1 && c != c2 && c != c3)
+		pointer++;
+	return pointer;
+#endif
+}
+
+/* Clear only items touched by the last message, untouched part of property buffer is still zeroed */
+
+static inline void clear_property_buffer(indigo_property *property) {
+	int count = property->count < INDIGO_MAX_ITEMS ? property->count + 1 : INDIGO_MAX_ITEMS;
+	memset(property, 0, sizeof(indigo_property) + count * sizeof(indigo_item));
+}
+
 static indigo_property_state parse_state(char *value) {
 	if (!strcmp(value, "Ok"))
 		return INDIGO_OK_STATE;
@@ -112,15 +168,166 @@ static indigo_rule parse_rule(char *value) {
 	return INDIGO_ANY_OF_MANY_RULE;
 }
 
+static indigo_array_type parse_array_type(char *value) {
+	if (!strcmp(value, "float"))
+		return INDIGO_ARRAY_FLOAT;
+	if (!strcmp(value, "int32"))
+		return INDIGO_ARRAY_INT32;
+	return INDIGO_ARRAY_DOUBLE;
+}
+
+static void parse_array_shape(indigo_item *item, char *value) {
+	char *end;
+	item->array.rank = 0;
+	item->array.count = 0;
+	while (item->array.rank < INDIGO_MAX_ARRAY_RANK) {
+		long dimension = strtol(value, &end, 10);
+		if (end == value || dimension < 0)
+			break;
+		item->array.shape[item->array.rank++] = (int)dimension;
+		item->array.count = item->array.rank == 1 ? dimension : item->array.count * dimension;
+		value = end;
+	}
+}
+
+#define PROPERTY_TABLE_SIZE 256  /* initial number of buckets, always power of 2 */
+#define ITEM_INDEX_SIZE (2 * INDIGO_MAX_ITEMS)
+
+typedef struct property_entry {
+	indigo_property *property;
+	unsigned hash;
+	struct property_entry *next;
+	bool indexed;
+	unsigned char item_index[ITEM_INDEX_SIZE]; /* item index + 1, 0 for empty slot */
+} property_entry;
+
 typedef struct {
 	char property_buffer[PROPERTY_SIZE];
 	indigo_device *device;
 	indigo_client *client;
 	int count;
-	indigo_property **properties;
+	int size;
+	property_entry **properties;
+	bool delta;
+	bool raw_blobs;
+	bool compression;
+	bool start_inflate;
 } parser_context;
 
+static unsigned string_hash(const char *string, unsigned hash) {
+	while (*string) {
+		hash ^= (unsigned char)*string++;
+		hash *= 16777619;
+	}
+	return hash;
+}
+
+static unsigned property_hash(const char *device, const char *name) {
+	return string_hash(name, string_hash(device, 2166136261u) * 16777619);
+}
+
+static void index_items(property_entry *entry) {
+	indigo_property *property = entry->property;
+	memset(entry->item_index, 0, ITEM_INDEX_SIZE);
+	entry->indexed = property->count <= INDIGO_MAX_ITEMS;
+	if (entry->indexed) {
+		for (int i = 0; i < property->count; i++) {
+			unsigned slot = string_hash(property->items[i].name, 2166136261u) % ITEM_INDEX_SIZE;
+			while (entry->item_index[slot])
+				slot = (slot + 1) % ITEM_INDEX_SIZE;
+			entry->item_index[slot] = i + 1;
+		}
+	}
+}
+
+static int find_item(property_entry *entry, const char *name, int hint) {
+	indigo_property *property = entry->property;
+	if (hint < property->count && !strncmp(property->items[hint].name, name, INDIGO_NAME_SIZE))
+		return hint;
+	if (entry->indexed) {
+		unsigned slot = string_hash(name, 2166136261u) % ITEM_INDEX_SIZE;
+		int index;
+		while ((index = entry->item_index[slot])) {
+			if (!strncmp(property->items[index - 1].name, name, INDIGO_NAME_SIZE))
+				return index - 1;
+			slot = (slot + 1) % ITEM_INDEX_SIZE;
+		}
+	} else {
+		for (int i = 0; i < property->count; i++) {
+			if (!strncmp(property->items[i].name, name, INDIGO_NAME_SIZE))
+				return i;
+		}
+	}
+	return -1;
+}
+
+static property_entry **find_property(parser_context *context, const char *device, const char *name) {
+	static property_entry *none = NULL;
+	if (context->size == 0)
+		return &none;
+	unsigned hash = property_hash(device, name);
+	property_entry **link = context->properties + (hash & (context->size - 1));
+	while (*link != NULL && ((*link)->hash != hash || strncmp((*link)->property->device, device, INDIGO_NAME_SIZE) || strncmp((*link)->property->name, name, INDIGO_NAME_SIZE)))
+		link = &(*link)->next;
+	return link;
+}
+
+static property_entry *add_property(parser_context *context, indigo_property *property) {
+	if (context->count >= context->size) {
+		int size = context->size ? context->size * 2 : PROPERTY_TABLE_SIZE;
+		property_entry **properties = malloc(size * sizeof(property_entry *));
+		assert(properties != NULL);
+		memset(properties, 0, size * sizeof(property_entry *));
+		for (int i = 0; i < context->size; i++) {
+			property_entry *entry = context->properties[i];
+			while (entry != NULL) {
+				property_entry *next = entry->next;
+				entry->next = properties[entry->hash & (size - 1)];
+				properties[entry->hash & (size - 1)] = entry;
+				entry = next;
+			}
+		}
+		free(context->properties);
+		context->properties = properties;
+		context->size = size;
+	}
+	property_entry *entry = malloc(sizeof(property_entry));
+	assert(entry != NULL);
+	entry->property = property;
+	entry->hash = property_hash(property->device, property->name);
+	entry->next = context->properties[entry->hash & (context->size - 1)];
+	context->properties[entry->hash & (context->size - 1)] = entry;
+	context->count++;
+	index_items(entry);
+	return entry;
+}
+
+static void remove_property(parser_context *context, property_entry **link) {
+	property_entry *entry = *link;
+	*link = entry->next;
+	free(entry);
+	context->count--;
+}
+
+/* BLOB and array data are decoded directly into the value of cached property item (if any) */
+static unsigned char *blob_destination(parser_context *context, indigo_property *other, indigo_item *other_item, long size) {
+	property_entry *entry = *find_property(context, other->device, other->name);
+	if (entry == NULL || entry->property->type != other->type)
+		return NULL;
+	int i = find_item(entry, other_item->name, (int)(other_item - other->items));
+	if (i < 0)
+		return NULL;
+	indigo_item *item = entry->property->items + i;
+	void **value = other->type == INDIGO_BLOB_VECTOR ? &item->blob.value : &item->array.value;
+	void *tmp = realloc(*value, size);
+	assert(tmp != NULL);
+	*value = tmp;
+	return tmp;
+}
+
 bool indigo_use_blob_urls = true;
+bool indigo_use_raw_blobs = true;
+bool indigo_use_compression = false;
 
 typedef void *(* parser_handler)(parser_state state, parser_context *context, char *name, char *value, char *message);
 
@@ -133,11 +340,13 @@ static void *def_number_vector_handler(parser_state state, parser_context *conte
 static void *def_switch_vector_handler(parser_state state, parser_context *context, char *name, char *value, char *message);
 static void *def_light_vector_handler(parser_state state, parser_context *context, char *name, char *value, char *message);
 static void *def_blob_vector_handler(parser_state state, parser_context *context, char *name, char *value, char *message);
+static void *def_array_vector_handler(parser_state state, parser_context *context, char *name, char *value, char *message);
 static void *set_text_vector_handler(parser_state state, parser_context *context, char *name, char *value, char *message);
 static void *set_number_vector_handler(parser_state state, parser_context *context, char *name, char *value, char *message);
 static void *set_switch_vector_handler(parser_state state, parser_context *context, char *name, char *value, char *message);
 static void *set_light_vector_handler(parser_state state, parser_context *context, char *name, char *value, char *message);
 static void *set_blob_vector_handler(parser_state state, parser_context *context, char *name, char *value, char *message);
+static void *set_array_vector_handler(parser_state state, parser_context *context, char *name, char *value, char *message);
 
 static void *enable_blob_handler(parser_state state, parser_context *context, char *name, char *value, char *message) {
 	indigo_client *client = context->client;
@@ -180,23 +389,41 @@ static void *get_properties_handler(parser_state state, parser_context *context,
 			else if (!strcmp(value, "2.0"))
 				version = INDIGO_VERSION_2_0;
 			if (version > client->version) {
-				assert(client->client_context != NULL);
-				int handle = ((indigo_adapter_context *)(client->client_context))->output;
-				indigo_printf(handle, "<switchProtocol version='%d.%d'/>\n", (version >> 8) & 0xFF, version & 0xFF);
+				indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
+				assert(client_context != NULL);
+				/* raw BLOBs and compression are used only if requested before protocol switch */
+				bool raw_blobs = indigo_use_raw_blobs && context->raw_blobs && version >= INDIGO_VERSION_2_0;
+				bool compression = indigo_use_compression && context->compression && version >= INDIGO_VERSION_2_0;
+				pthread_mutex_lock(&client_context->output_mutex);
+				/* compressed stream starts right after the tag */
+				indigo_buffer_printf(client_context->output_buffer, "<switchProtocol version='%d.%d'%s%s", (version >> 8) & 0xFF, version & 0xFF, raw_blobs ? " blob='raw'" : "", compression ? " compression='deflate'/>" : "/>\n");
+				indigo_buffer_flush(client_context->output_buffer);
+				if (compression && !indigo_buffer_compress(client_context->output_buffer))
+					indigo_error("XML Parser: can't start output compression");
+				client_context->raw_blobs = raw_blobs;
+				pthread_mutex_unlock(&client_context->output_mutex);
 				client->version = version;
 			}
+		} else if (!strcmp(name, "blob")) {
+			context->raw_blobs = !strcmp(value, "raw");
+		} else if (!strcmp(name, "compression")) {
+			context->compression = !strcmp(value, "deflate");
 		} else if (!strncmp(name, "device",INDIGO_NAME_SIZE)) {
 			strcpy(property->device, value);
 		} else if (!strncmp(name, "name",INDIGO_NAME_SIZE)) {
 			indigo_copy_property_name(client->version, property, value);;
 		}
 	} else if (state == END_TAG) {
+		context->raw_blobs = false;
+		context->compression = false;
 		if (client->version == INDIGO_VERSION_LEGACY)
 			client->enable_blob = INDIGO_ENABLE_BLOB_ALSO;
 		else
 			client->enable_blob = INDIGO_ENABLE_BLOB_URL;
+		indigo_xml_device_adapter_cork(client, true);
 		indigo_enumerate_properties(client, property);
-		memset(property, 0, PROPERTY_SIZE);
+		indigo_xml_device_adapter_cork(client, false);
+		clear_property_buffer(property);
 		return top_level_handler;
 	}
 	return get_properties_handler;
@@ -237,7 +464,7 @@ static void *new_text_vector_handler(parser_state state, parser_context *context
 		}
 	} else if (state == END_TAG) {
 		indigo_change_property(client, property);
-		memset(property, 0, PROPERTY_SIZE);
+		clear_property_buffer(property);
 		return top_level_handler;
 	}
 	return new_text_vector_handler;
@@ -252,7 +479,7 @@ static void *new_one_number_vector_handler(parser_state state, parser_context *c
 			indigo_copy_item_name(client ? client->version : INDIGO_VERSION_CURRENT, property, property->items+property->count-1, value);
 		}
 	} else if (state == TEXT) {
-		property->items[property->count-1].number.value = atof(value);
+		property->items[property->count-1].number.value = indigo_atof(value);
 	} else if (state == END_TAG) {
 		return new_number_vector_handler;
 	}
@@ -278,7 +505,7 @@ static void *new_number_vector_handler(parser_state state, parser_context *conte
 		}
 	} else if (state == END_TAG) {
 		indigo_change_property(client, property);
-		memset(property, 0, PROPERTY_SIZE);
+		clear_property_buffer(property);
 		return top_level_handler;
 	}
 	return new_number_vector_handler;
@@ -320,7 +547,7 @@ static void *new_switch_vector_handler(parser_state state, parser_context *conte
 		return new_switch_vector_handler;
 	} else if (state == END_TAG) {
 		indigo_change_property(client, property);
-		memset(property, 0, PROPERTY_SIZE);
+		clear_property_buffer(property);
 		return top_level_handler;
 	}
 	return new_switch_vector_handler;
@@ -328,73 +555,99 @@ static void *new_switch_vector_handler(parser_state state, parser_context *conte
 
 static void *switch_protocol_handler(parser_state state, parser_context *context, char *name, char *value, char *message) {
 	indigo_device *device = context->device;
-	assert(device != NULL);
 	INDIGO_TRACE_PROTOCOL(indigo_trace("XML Parser: switch_protocol_handler %s '%s' '%s'", parser_state_name[state], name != NULL ? name : "", value != NULL ? value : ""));
 	if (state == ATTRIBUTE_VALUE) {
-		if (!strcmp(name, "version")) {
+		if (!strcmp(name, "version") && device != NULL) {
 			int major, minor;
 			sscanf(value, "%d.%d", &major, &minor);
 			device->version = major << 8 | minor;
+		} else if (!strcmp(name, "blob") && device != NULL) {
+			((indigo_adapter_context *)device->device_context)->raw_blobs = !strcmp(value, "raw");
+		} else if (!strcmp(name, "compression")) {
+			/* server accepts it from client it switched to compression, client only if it asked for it */
+			if (device != NULL)
+				context->compression = indigo_use_compression && !strcmp(value, "deflate");
+			else
+				context->compression = ((indigo_adapter_context *)context->client->client_context)->output_buffer->deflater != NULL && !strcmp(value, "deflate");
 		}
 	} else if (state == END_TAG) {
+		if (context->compression) {
+			/* everything after this tag is compressed */
+			context->compression = false;
+			context->start_inflate = true;
+			if (device != NULL) {
+				/* client confirms it by the same tag and compresses its output as well */
+				indigo_adapter_context *device_context = (indigo_adapter_context *)device->device_context;
+				pthread_mutex_lock(&device_context->output_mutex);
+				indigo_buffer_printf(device_context->output_buffer, "<switchProtocol compression='deflate'/>");
+				indigo_buffer_flush(device_context->output_buffer);
+				if (!indigo_buffer_compress(device_context->output_buffer))
+					indigo_error("XML Parser: can't start output compression");
+				pthread_mutex_unlock(&device_context->output_mutex);
+			}
+		}
 		return top_level_handler;
 	}
 	return switch_protocol_handler;
 }
 
 static void set_property(parser_context *context, indigo_property *other, char *message) {
-	for (int index = 0; index < context->count; index++) {
-		indigo_property *property = context->properties[index];
-		if (property != NULL && !strncmp(property->device, other->device, INDIGO_NAME_SIZE) && !strncmp(property->name, other->name, INDIGO_NAME_SIZE)) {
-			property->state = other->state;
-			if (property->type == INDIGO_SWITCH_VECTOR && property->rule != INDIGO_ANY_OF_MANY_RULE) {
-				for (int j = 0; j < property->count; j++) {
-					property->items[j].sw.value = false;
-				}
-			}
-			for (int i = 0; i < other->count; i++) {
-				indigo_item *other_item = &other->items[i];
-				for (int j = 0; j < property->count; j++) {
-					indigo_item *property_item = &property->items[j];
-					if (!strcmp(property_item->name, other_item->name)) {
-						switch (property->type) {
-							case INDIGO_TEXT_VECTOR:
-								strncpy(property_item->text.value, other_item->text.value, INDIGO_VALUE_SIZE);
-								break;
-							case INDIGO_NUMBER_VECTOR:
-								property_item->number.value = other_item->number.value;
-								if (property_item->number.value < property_item->number.min)
-									property_item->number.value = property_item->number.min;
-								if (property_item->number.value > property_item->number.max)
-									property_item->number.value = property_item->number.max;
-								property_item->number.target = other_item->number.target;
-								break;
-							case INDIGO_SWITCH_VECTOR:
-								property_item->sw.value = other_item->sw.value;
-								break;
-							case INDIGO_LIGHT_VECTOR:
-								property_item->light.value = other_item->light.value;
-								break;
-							case INDIGO_BLOB_VECTOR:
-								strncpy(property_item->blob.format, other_item->blob.format, INDIGO_NAME_SIZE);
-								strncpy(property_item->blob.url, other_item->blob.url, INDIGO_VALUE_SIZE);
-								property_item->blob.size = other_item->blob.size;
-								if (property_item->blob.value != NULL)
-									property_item->blob.value = realloc(property_item->blob.value, property_item->blob.size);
-								else
-									property_item->blob.value = malloc(property_item->blob.size);
-								memcpy(property_item->blob.value, other_item->blob.value, property_item->blob.size);
-								break;
-						}
-						break;
-					}
+	property_entry *entry = *find_property(context, other->device, other->name);
+	if (entry == NULL)
+		return;
+	indigo_property *property = entry->property;
+	property->state = other->state;
+	if (property->type == INDIGO_SWITCH_VECTOR && property->rule != INDIGO_ANY_OF_MANY_RULE) {
+		for (int j = 0; j < property->count; j++) {
+			property->items[j].sw.value = false;
+		}
+	}
+	for (int i = 0; i < other->count; i++) {
+		indigo_item *other_item = &other->items[i];
+		int j = find_item(entry, other_item->name, i);
+		if (j < 0)
+			continue;
+		indigo_item *property_item = &property->items[j];
+		switch (property->type) {
+			case INDIGO_TEXT_VECTOR:
+				strncpy(property_item->text.value, other_item->text.value, INDIGO_VALUE_SIZE);
+				break;
+			case INDIGO_NUMBER_VECTOR:
+				property_item->number.value = other_item->number.value;
+				if (property_item->number.value < property_item->number.min)
+					property_item->number.value = property_item->number.min;
+				if (property_item->number.value > property_item->number.max)
+					property_item->number.value = property_item->number.max;
+				property_item->number.target = other_item->number.target;
+				break;
+			case INDIGO_SWITCH_VECTOR:
+				property_item->sw.value = other_item->sw.value;
+				break;
+			case INDIGO_LIGHT_VECTOR:
+				property_item->light.value = other_item->light.value;
+				break;
+			case INDIGO_BLOB_VECTOR:
+				strncpy(property_item->blob.format, other_item->blob.format, INDIGO_NAME_SIZE);
+				strncpy(property_item->blob.url, other_item->blob.url, INDIGO_VALUE_SIZE);
+				property_item->blob.size = other_item->blob.size;
+				if (property_item->blob.value != other_item->blob.value) {
+					if (property_item->blob.value != NULL)
+						property_item->blob.value = realloc(property_item->blob.value, property_item->blob.size);
+					else
+						property_item->blob.value = malloc(property_item->blob.size);
+					memcpy(property_item->blob.value, other_item->blob.value, property_item->blob.size);
 				}
-			}
-			INDIGO_TRACE_PROTOCOL(indigo_trace("XML Parser: set_property '%s' '%s' %d", property->device, property->name, index));
-			indigo_update_property(context->device, property, *message ? message : NULL);
-			break;
+				break;
+			case INDIGO_ARRAY_VECTOR:
+				if (property_item->array.value != NULL && property_item->array.value != other_item->array.value)
+					free(property_item->array.value);
+				property_item->array = other_item->array;
+				other_item->array.value = NULL;
+				break;
 		}
 	}
+	INDIGO_TRACE_PROTOCOL(indigo_trace("XML Parser: set_property '%s' '%s'", property->device, property->name));
+	indigo_update_property(context->device, property, *message ? message : NULL);
 }
 
 static void *set_one_text_vector_handler(parser_state state, parser_context *context, char *name, char *value, char *message) {
@@ -437,7 +690,7 @@ static void *set_text_vector_handler(parser_state state, parser_context *context
 		}
 	} else if (state == END_TAG) {
 		set_property(context, property, message);
-		memset(property, 0, PROPERTY_SIZE);
+		clear_property_buffer(property);
 		return top_level_handler;
 	}
 	return set_text_vector_handler;
@@ -451,10 +704,10 @@ static void *set_one_number_vector_handler(parser_state state, parser_context *c
 		if (!strcmp(name, "name")) {
 			indigo_copy_item_name(device->version, property, property->items+property->count-1, value);
 		} else if (!strcmp(name, "target")) {
-			property->items[property->count-1].number.target = atof(value);
+			property->items[property->count-1].number.target = indigo_atof(value);
 		}
 	} else if (state == TEXT) {
-		property->items[property->count-1].number.value = atof(value);
+		property->items[property->count-1].number.value = indigo_atof(value);
 	} else if (state == END_TAG) {
 		return set_number_vector_handler;
 	}
@@ -485,7 +738,7 @@ static void *set_number_vector_handler(parser_state state, parser_context *conte
 		}
 	} else if (state == END_TAG) {
 		set_property(context, property, message);
-		memset(property, 0, PROPERTY_SIZE);
+		clear_property_buffer(property);
 		return top_level_handler;
 	}
 	return set_number_vector_handler;
@@ -531,7 +784,7 @@ static void *set_switch_vector_handler(parser_state state, parser_context *conte
 		}
 	} else if (state == END_TAG) {
 		set_property(context, property, message);
-		memset(property, 0, PROPERTY_SIZE);
+		clear_property_buffer(property);
 		return top_level_handler;
 	}
 	return set_switch_vector_handler;
@@ -577,7 +830,7 @@ static void *set_light_vector_handler(parser_state state, parser_context *contex
 		}
 	} else if (state == END_TAG) {
 		set_property(context, property, message);
-		memset(property, 0, PROPERTY_SIZE);
+		clear_property_buffer(property);
 		return top_level_handler;
 	}
 	return set_light_vector_handler;
@@ -634,27 +887,110 @@ static void *set_blob_vector_handler(parser_state state, parser_context *context
 		}
 	} else if (state == END_TAG) {
 		set_property(context, property, message);
-		memset(property, 0, PROPERTY_SIZE);
+		clear_property_buffer(property);
 		return top_level_handler;
 	}
 	return set_blob_vector_handler;
 }
 
-static void def_property(parser_context *context, indigo_property *other, char *message) {
-	indigo_property *property = NULL;
-	int index;
-	for (index = 0; index < context->count; index++) {
-		property = context->properties[index];
-		if (property == NULL)
-			break;
-		if (!strncmp(property->device, other->device, INDIGO_NAME_SIZE) && !strncmp(property->name, other->name, INDIGO_NAME_SIZE))
-			break;
+static void *set_one_array_vector_handler(parser_state state, parser_context *context, char *name, char *value, char *message) {
+	indigo_property *property = (indigo_property *)context->property_buffer;
+	indigo_device *device = context->device;
+	INDIGO_DEBUG_PROTOCOL(if (state == BLOB))
+	INDIGO_TRACE_PROTOCOL(indigo_trace("XML Parser: set_one_array_vector_handler %s '%s' DATA", parser_state_name[state], name != NULL ? name : ""));
+	INDIGO_DEBUG_PROTOCOL(else)
+	INDIGO_TRACE_PROTOCOL(indigo_trace("XML Parser: set_one_array_vector_handler %s '%s' '%s'", parser_state_name[state], name != NULL ? name : "", value != NULL ? value : ""));
+	if (state == ATTRIBUTE_VALUE) {
+		if (!strcmp(name, "name")) {
+			indigo_copy_item_name(device->version, property, property->items+property->count-1, value);
+		} else if (!strcmp(name, "type")) {
+			property->items[property->count-1].array.type = parse_array_type(value);
+		} else if (!strcmp(name, "shape")) {
+			parse_array_shape(property->items+property->count-1, value);
+		}
+	} else if (state == BLOB) {
+		indigo_item *item = property->items + property->count - 1;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		/* elements are received in little endian byte order */
+		int element_size = indigo_array_element_size(item->array.type);
+		for (long i = 0; i < item->array.count; i++) {
+			char *element = value + i * element_size;
+			for (int j = 0; j < element_size / 2; j++) {
+				char c = element[j];
+				element[j] = element[element_size - 1 - j];
+				element[element_size - 1 - j] = c;
+			}
+		}
+#endif
+		item->array.value = value;
+	} else if (state == END_TAG) {
+		return set_array_vector_handler;
 	}
-	if (index == context->count) {
-		context->properties = realloc(context->properties, context->count * 2 * sizeof(indigo_property *));
-		memset(context->properties + context->count, 0, context->count * sizeof(indigo_property *));
-		context->count *= 2;
-		property = NULL;
+	return set_one_array_vector_handler;
+}
+
+static void *set_array_vector_handler(parser_state state, parser_context *context, char *name, char *value, char *message) {
+	indigo_property *property = (indigo_property *)context->property_buffer;
+	indigo_device *device = context->device;
+	INDIGO_TRACE_PROTOCOL(indigo_trace("XML Parser: set_array_vector_handler %s '%s' '%s'", parser_state_name[state], name != NULL ? name : "", value != NULL ? value : ""));
+	if (state == BEGIN_TAG) {
+		if (!strcmp(name, "oneArray")) {
+			property->count++;
+			return set_one_array_vector_handler;
+		}
+	} else if (state == ATTRIBUTE_VALUE) {
+		if (!strcmp(name, "device")) {
+			if (indigo_use_host_suffix)
+				snprintf(property->device, INDIGO_NAME_SIZE, "%s %s", value, context->device->name);
+			else
+				strncpy(property->device, value, INDIGO_NAME_SIZE);
+		} else if (!strcmp(name, "name")) {
+			indigo_copy_property_name(device->version, property, value);
+		} else if (!strcmp(name, "state")) {
+			property->state = parse_state(value);
+		} else if (!strcmp(name, "message")) {
+			strncpy(message, value, INDIGO_VALUE_SIZE);
+		}
+	} else if (state == END_TAG) {
+		set_property(context, property, message);
+		for (int i = 0; i < property->count; i++) {
+			if (property->items[i].array.value != NULL)
+				free(property->items[i].array.value);
+		}
+		clear_property_buffer(property);
+		return top_level_handler;
+	}
+	return set_array_vector_handler;
+}
+
+static void def_property(parser_context *context, indigo_property *other, char *message) {
+	property_entry *entry = *find_property(context, other->device, other->name);
+	indigo_property *property = entry ? entry->property : NULL;
+	if (context->delta) {
+		context->delta = false;
+		if (property != NULL && property->type == other->type) {
+			int first = property->count;
+			for (int i = 0; i < other->count; i++) {
+				indigo_item *other_item = other->items + i;
+				int j = find_item(entry, other_item->name, i);
+				if (j < 0) {
+					j = property->count;
+					entry->property = property = indigo_resize_property(property, property->count + 1);
+					memcpy(property->items + j, other_item, sizeof(indigo_item));
+					index_items(entry);
+				} else {
+					if (property->type == INDIGO_ARRAY_VECTOR && property->items[j].array.value != NULL)
+						free(property->items[j].array.value);
+					memcpy(property->items + j, other_item, sizeof(indigo_item));
+				}
+				if (j < first)
+					first = j;
+			}
+			property->state = other->state;
+			INDIGO_TRACE_PROTOCOL(indigo_trace("XML Parser: def_property items '%s' '%s'", property->device, property->name));
+			indigo_define_property_items(context->device, property, first, property->count - first, *message ? message : NULL);
+			return;
+		}
 	}
 	if (property == NULL) {
 		switch (other->type) {
@@ -686,15 +1022,22 @@ static void def_property(parser_context *context, indigo_property *other, char *
 					}
 				}
 				if (context->device != NULL) {
-					int handle = ((indigo_adapter_context *)context->device->device_context)->output;
-					int use_url = indigo_use_blob_urls && *((indigo_adapter_context *)context->device->device_context)->url_prefix != 0 && other->version != INDIGO_VERSION_LEGACY;
-					indigo_printf(handle, "<enableBLOB device='%s' name='%s'>%s</enableBLOB>\n", property->device, indigo_property_name(context->device->version, property), use_url ? "URL" : "Also");
+					indigo_adapter_context *device_context = (indigo_adapter_context *)context->device->device_context;
+					int use_url = indigo_use_blob_urls && *device_context->url_prefix != 0 && other->version != INDIGO_VERSION_LEGACY;
+					pthread_mutex_lock(&device_context->output_mutex);
+					indigo_buffer_printf(device_context->output_buffer, "<enableBLOB device='%s' name='%s'>%s</enableBLOB>\n", property->device, indigo_property_name(context->device->version, property), use_url ? "URL" : "Also");
+					indigo_buffer_flush(device_context->output_buffer);
+					pthread_mutex_unlock(&device_context->output_mutex);
 				}
 				break;
+			case INDIGO_ARRAY_VECTOR:
+				property = indigo_init_array_property(property, other->device, other->name, other->group, other->label, other->state, other->count);
+				memcpy(property->items, other->items, other->count * sizeof(indigo_item));
+				break;
 		}
-		context->properties[index] = property;
+		add_property(context, property);
 	}
-	INDIGO_TRACE_PROTOCOL(indigo_trace("XML Parser: def_property '%s' '%s' %d", property->device, property->name, index));
+	INDIGO_TRACE_PROTOCOL(indigo_trace("XML Parser: def_property '%s' '%s'", property->device, property->name));
 	indigo_define_property(context->device, property, *message ? message : NULL);
 }
 
@@ -741,12 +1084,14 @@ static void *def_text_vector_handler(parser_state state, parser_context *context
 			property->state = parse_state(value);
 		} else if (!strcmp(name, "perm")) {
 			property->perm = parse_perm(value);
+		} else if (!strcmp(name, "delta")) {
+			context->delta = !strcmp(value, "true");
 		} else if (!strcmp(name, "message")) {
 			strncpy(message, value, INDIGO_VALUE_SIZE);
 		}
 	} else if (state == END_TAG) {
 		def_property(context, property, message);
-		memset(property, 0, PROPERTY_SIZE);
+		clear_property_buffer(property);
 		return top_level_handler;
 	}
 	return def_text_vector_handler;
@@ -762,16 +1107,16 @@ static void *def_number_handler(parser_state state, parser_context *context, cha
 		} else if (!strcmp(name, "label")) {
 			strncpy(property->items[property->count-1].label, value, INDIGO_VALUE_SIZE);
 		} else if (!strcmp(name, "min")) {
-			property->items[property->count-1].number.min = atof(value);
+			property->items[property->count-1].number.min = indigo_atof(value);
 		} else if (!strcmp(name, "max")) {
-			property->items[property->count-1].number.max = atof(value);
+			property->items[property->count-1].number.max = indigo_atof(value);
 		} else if (!strcmp(name, "step")) {
-			property->items[property->count-1].number.step = atof(value);
+			property->items[property->count-1].number.step = indigo_atof(value);
 		} else if (!strcmp(name, "format")) {
 			strncpy(property->items[property->count-1].number.format, value, INDIGO_NAME_SIZE);
 		}
 	} else if (state == TEXT) {
-		property->items[property->count-1].number.value = atof(value);
+		property->items[property->count-1].number.value = indigo_atof(value);
 	} else if (state == END_TAG) {
 		return def_number_vector_handler;
 	}
@@ -803,12 +1148,14 @@ static void *def_number_vector_handler(parser_state state, parser_context *conte
 			property->state = parse_state(value);
 		} else if (!strcmp(name, "perm")) {
 			property->perm = parse_perm(value);
+		} else if (!strcmp(name, "delta")) {
+			context->delta = !strcmp(value, "true");
 		} else if (!strcmp(name, "message")) {
 			strncpy(message, value, INDIGO_VALUE_SIZE);
 		}
 	} else if (state == END_TAG) {
 		def_property(context, property, message);
-		memset(property, 0, PROPERTY_SIZE);
+		clear_property_buffer(property);
 		return top_level_handler;
 	}
 	return def_number_vector_handler;
@@ -859,12 +1206,14 @@ static void *def_switch_vector_handler(parser_state state, parser_context *conte
 			property->perm = parse_perm(value);
 		} else if (!strcmp(name, "rule")) {
 			property->rule = parse_rule(value);
+		} else if (!strcmp(name, "delta")) {
+			context->delta = !strcmp(value, "true");
 		} else if (!strcmp(name, "message")) {
 			strncpy(message, value, INDIGO_VALUE_SIZE);
 		}
 	} else if (state == END_TAG) {
 		def_property(context, property, message);
-		memset(property, 0, PROPERTY_SIZE);
+		clear_property_buffer(property);
 		return top_level_handler;
 	}
 	return def_switch_vector_handler;
@@ -911,12 +1260,14 @@ static void *def_light_vector_handler(parser_state state, parser_context *contex
 			strncpy(property->label, value, INDIGO_VALUE_SIZE);
 		} else if (!strcmp(name, "state")) {
 			property->state = parse_state(value);
+		} else if (!strcmp(name, "delta")) {
+			context->delta = !strcmp(value, "true");
 		} else if (!strcmp(name, "message")) {
 			strncpy(message, value, INDIGO_VALUE_SIZE);
 		}
 	} else if (state == END_TAG) {
 		def_property(context, property, message);
-		memset(property, 0, PROPERTY_SIZE);
+		clear_property_buffer(property);
 		return top_level_handler;
 	}
 	return def_light_vector_handler;
@@ -967,17 +1318,75 @@ static void *def_blob_vector_handler(parser_state state, parser_context *context
 			property->state = parse_state(value);
 		} else if (!strcmp(name, "perm")) {
 			property->perm = parse_perm(value);
+		} else if (!strcmp(name, "delta")) {
+			context->delta = !strcmp(value, "true");
 		} else if (!strcmp(name, "message")) {
 			strncpy(message, value, INDIGO_VALUE_SIZE);
 		}
 	} else if (state == END_TAG) {
 		def_property(context, property, message);
-		memset(property, 0, PROPERTY_SIZE);
+		clear_property_buffer(property);
 		return top_level_handler;
 	}
 	return def_blob_vector_handler;
 }
 
+static void *def_array_handler(parser_state state, parser_context *context, char *name, char *value, char *message) {
+	indigo_property *property = (indigo_property *)context->property_buffer;
+	indigo_device *device = context->device;
+	INDIGO_TRACE_PROTOCOL(indigo_trace("XML Parser: def_array_handler %s '%s' '%s'", parser_state_name[state], name != NULL ? name : "", value != NULL ? value : ""));
+	if (state == ATTRIBUTE_VALUE) {
+		if (!strcmp(name, "name")) {
+			indigo_copy_item_name(device->version, property, property->items+property->count-1, value);
+		} else if (!strcmp(name, "label")) {
+			strncpy(property->items[property->count-1].label, value, INDIGO_VALUE_SIZE);
+		} else if (!strcmp(name, "type")) {
+			property->items[property->count-1].array.type = parse_array_type(value);
+		}
+	} else if (state == END_TAG) {
+		return def_array_vector_handler;
+	}
+	return def_array_handler;
+}
+
+static void *def_array_vector_handler(parser_state state, parser_context *context, char *name, char *value, char *message) {
+	indigo_property *property = (indigo_property *)context->property_buffer;
+	indigo_device *device = context->device;
+	INDIGO_TRACE_PROTOCOL(indigo_trace("XML Parser: def_array_vector_handler %s '%s' '%s'", parser_state_name[state], name != NULL ? name : "", value != NULL ? value : ""));
+	if (state == BEGIN_TAG) {
+		if (!strcmp(name, "defArray")) {
+			property->count++;
+			return def_array_handler;
+		}
+	} else if (state == ATTRIBUTE_VALUE) {
+		if (!strcmp(name, "device")) {
+			if (indigo_use_host_suffix)
+				snprintf(property->device, INDIGO_NAME_SIZE, "%s %s", value, context->device->name);
+			else
+				strncpy(property->device, value, INDIGO_NAME_SIZE);
+		} else if (!strcmp(name, "name")) {
+			indigo_copy_property_name(device->version, property, value);
+		} else if (!strcmp(name, "group")) {
+			strncpy(property->group, value,INDIGO_NAME_SIZE);
+		} else if (!strcmp(name, "label")) {
+			strncpy(property->label, value, INDIGO_VALUE_SIZE);
+		} else if (!strcmp(name, "state")) {
+			property->state = parse_state(value);
+		} else if (!strcmp(name, "perm")) {
+			property->perm = parse_perm(value);
+		} else if (!strcmp(name, "delta")) {
+			context->delta = !strcmp(value, "true");
+		} else if (!strcmp(name, "message")) {
+			strncpy(message, value, INDIGO_VALUE_SIZE);
+		}
+	} else if (state == END_TAG) {
+		def_property(context, property, message);
+		clear_property_buffer(property);
+		return top_level_handler;
+	}
+	return def_array_vector_handler;
+}
+
 static void *del_property_handler(parser_state state, parser_context *context, char *name, char *value, char *message) {
 	indigo_property *property = (indigo_property *)context->property_buffer;
 	indigo_device *device = context->device;
@@ -995,31 +1404,87 @@ static void *del_property_handler(parser_state state, parser_context *context, c
 		}
 	} else if (state == END_TAG) {
 		if (*property->name) {
-			for (int i = 0; i < context->count; i++) {
-				indigo_property *tmp = context->properties[i];
-				if (tmp != NULL && !strncmp(tmp->device, property->device, INDIGO_NAME_SIZE) && !strncmp(tmp->name, property->name, INDIGO_NAME_SIZE)) {
-					indigo_delete_property(device, tmp, *message ? message : NULL);
-					indigo_release_property(tmp);
-					context->properties[i] = NULL;
-					break;
-				}
+			property_entry **link = find_property(context, property->device, property->name);
+			if (*link != NULL) {
+				indigo_property *tmp = (*link)->property;
+				indigo_delete_property(device, tmp, *message ? message : NULL);
+				indigo_release_property(tmp);
+				remove_property(context, link);
 			}
 		} else {
-			for (int i = 0; i < context->count; i++) {
-				indigo_property *tmp = context->properties[i];
-				if (tmp != NULL && !strncmp(tmp->device, property->device, INDIGO_NAME_SIZE)) {
-					indigo_delete_property(device, tmp, *message ? message : NULL);
-					indigo_release_property(tmp);
-					context->properties[i] = NULL;
+			for (int i = 0; i < context->size; i++) {
+				property_entry **link = context->properties + i;
+				while (*link != NULL) {
+					indigo_property *tmp = (*link)->property;
+					if (!strncmp(tmp->device, property->device, INDIGO_NAME_SIZE)) {
+						indigo_delete_property(device, tmp, *message ? message : NULL);
+						indigo_release_property(tmp);
+						remove_property(context, link);
+					} else {
+						link = &(*link)->next;
+					}
 				}
 			}
 		}
-		memset(property, 0, PROPERTY_SIZE);
+		clear_property_buffer(property);
 		return top_level_handler;
 	}
 	return del_property_handler;
 }
 
+static void *del_items_handler(parser_state state, parser_context *context, char *name, char *value, char *message);
+
+static void *del_item_handler(parser_state state, parser_context *context, char *name, char *value, char *message) {
+	indigo_property *property = (indigo_property *)context->property_buffer;
+	indigo_device *device = context->device;
+	INDIGO_TRACE_PROTOCOL(indigo_trace("XML Parser: del_item_handler %s '%s' '%s'", parser_state_name[state], name != NULL ? name : "", value != NULL ? value : ""));
+	if (state == ATTRIBUTE_VALUE) {
+		if (!strcmp(name, "name")) {
+			indigo_copy_item_name(device->version, property, property->items+property->count-1, value);
+		}
+	} else if (state == END_TAG) {
+		return del_items_handler;
+	}
+	return del_item_handler;
+}
+
+static void *del_items_handler(parser_state state, parser_context *context, char *name, char *value, char *message) {
+	indigo_property *property = (indigo_property *)context->property_buffer;
+	indigo_device *device = context->device;
+	INDIGO_TRACE_PROTOCOL(indigo_trace("XML Parser: del_items_handler %s '%s' '%s'", parser_state_name[state], name != NULL ? name : "", value != NULL ? value : ""));
+	if (state == BEGIN_TAG) {
+		if (!strcmp(name, "delItem") && property->count < INDIGO_MAX_ITEMS) {
+			property->count++;
+			return del_item_handler;
+		}
+	} else if (state == ATTRIBUTE_VALUE) {
+		if (!strcmp(name, "device")) {
+			if (indigo_use_host_suffix)
+				snprintf(property->device, INDIGO_NAME_SIZE, "%s %s", value, context->device->name);
+			else
+				strncpy(property->device, value, INDIGO_NAME_SIZE);
+		} else if (!strcmp(name, "name")) {
+			indigo_copy_property_name(device->version, property, value);
+		} else if (!strcmp(name, "message")) {
+			strncpy(message, value, INDIGO_VALUE_SIZE);
+		}
+	} else if (state == END_TAG) {
+		property_entry *entry = *find_property(context, property->device, property->name);
+		if (entry != NULL) {
+			for (int j = 0; j < property->count; j++) {
+				int k = find_item(entry, property->items[j].name, j);
+				if (k >= 0) {
+					indigo_delete_property_items(device, entry->property, k, 1, *message ? message : NULL);
+					index_items(entry);
+				}
+			}
+		}
+		clear_property_buffer(property);
+		return top_level_handler;
+	}
+	return del_items_handler;
+}
+
 static void *message_handler(parser_state state, parser_context *context, char *name, char *value, char *message) {
 	indigo_property *property = (indigo_property *)context->property_buffer;
 	indigo_device *device = context->device;
@@ -1030,7 +1495,7 @@ static void *message_handler(parser_state state, parser_context *context, char *
 		}
 	} else if (state == END_TAG) {
 		indigo_send_message(device, *message ? message : NULL);
-		memset(property, 0, PROPERTY_SIZE);
+		clear_property_buffer(property);
 		return top_level_handler;
 	}
 	return message_handler;
@@ -1080,6 +1545,10 @@ static void *top_level_handler(parser_state state, parser_context *context, char
 			property->type = INDIGO_BLOB_VECTOR;
 			return set_blob_vector_handler;
 		}
+		if (!strcmp(name, "setArrayVector")) {
+			property->type = INDIGO_ARRAY_VECTOR;
+			return set_array_vector_handler;
+		}
 		if (!strcmp(name, "defTextVector")) {
 			property->type = INDIGO_TEXT_VECTOR;
 			return def_text_vector_handler;
@@ -1100,16 +1569,28 @@ static void *top_level_handler(parser_state state, parser_context *context, char
 			property->type = INDIGO_BLOB_VECTOR;
 			return def_blob_vector_handler;
 		}
+		if (!strcmp(name, "defArrayVector")) {
+			property->type = INDIGO_ARRAY_VECTOR;
+			return def_array_vector_handler;
+		}
 		if (!strcmp(name, "delProperty"))
 			return del_property_handler;
+		if (!strcmp(name, "delItems"))
+			return del_items_handler;
 		if (!strcmp(name, "message"))
 			return message_handler;
 	}
 	return top_level_handler;
 }
 
+static ssize_t read_input(int handle, indigo_inflater *inflater, void *buffer, long length) {
+	if (inflater != NULL)
+		return indigo_inflater_read(inflater, handle, buffer, length);
+	return read(handle, buffer, length);
+}
+
 void indigo_xml_parse(indigo_device *device, indigo_client *client) {
-	char *buffer = malloc(BUFFER_SIZE+3); /* BUFFER_SIZE % 4 == 0 and keep always +3 for base64 alignmet */
+	char *buffer = malloc(BUFFER_SIZE+4+SCAN_PADDING); /* BUFFER_SIZE % 4 == 0 and keep always +3 for base64 alignmet and +1 for \0 */
 	assert(buffer != NULL);
 	char *value_buffer = malloc(BUFFER_SIZE+1); /* +1 to accomodate \0" */
 	assert(value_buffer != NULL);
@@ -1119,6 +1600,7 @@ void indigo_xml_parse(indigo_device *device, indigo_client *client) {
 	char *buffer_end = NULL;
 	char *name_pointer = name_buffer;
 	char *value_pointer = value_buffer;
+	unsigned char *blob_start = NULL;
 	unsigned char *blob_pointer = NULL;
 	long blob_size = 0;
 	char message[INDIGO_VALUE_SIZE];
@@ -1137,19 +1619,19 @@ void indigo_xml_parse(indigo_device *device, indigo_client *client) {
 	parser_context context;
 	context.client = client;
 	context.device = device;
-	if (device != NULL) {
-		context.count = 32;
-		context.properties = malloc(context.count * sizeof(indigo_property *));
-	} else {
-		context.count = 0;
-		context.properties = NULL;
-	}
-	memset(context.properties, 0, context.count * sizeof(indigo_property *));
+	context.delta = false;
+	context.raw_blobs = false;
+	context.compression = false;
+	context.start_inflate = false;
+	context.count = 0;
+	context.size = 0;
+	context.properties = NULL;
 
 	indigo_property *property = (indigo_property *)&context.property_buffer;
 	memset(context.property_buffer, 0, PROPERTY_SIZE);
 
 	int handle = 0;
+	indigo_inflater *inflater = NULL;
 	if (device != NULL) {
 		handle = ((indigo_adapter_context *)device->device_context)->input;
 		device->enumerate_properties(device, client, NULL);
@@ -1161,12 +1643,74 @@ void indigo_xml_parse(indigo_device *device, indigo_client *client) {
 		assert(pointer - buffer <= BUFFER_SIZE);
 		assert(value_pointer - value_buffer <= BUFFER_SIZE);
 		assert(name_pointer - name_buffer <= INDIGO_NAME_SIZE);
+		if (context.start_inflate) {
+			/* rest of input (incl. already read part) is compressed */
+			context.start_inflate = false;
+			inflater = indigo_create_inflater(pointer, buffer_end - pointer);
+			if (inflater == NULL) {
+				indigo_error("XML Parser: can't start input decompression");
+				goto exit_loop;
+			}
+			pointer = buffer_end = buffer;
+			*pointer = 0;
+		}
 		if (state == ERROR) {
 			indigo_error("XML Parser: syntax error");
 			goto exit_loop;
 		}
+		if (entity_pointer == NULL && *pointer) {
+			/* fast path - skip or copy runs of characters not changing parser state */
+			char *end = pointer;
+			switch (state) {
+				case IDLE:
+					end = scan_to(pointer, '<', '&', '<');
+					break;
+				case TEXT:
+					end = scan_to(pointer, '<', '&', '<');
+					if (depth == 2 || handler == enable_blob_handler) {
+						long length = INDIGO_VALUE_SIZE - (value_pointer - value_buffer);
+						if (length > end - pointer)
+							length = end - pointer;
+						if (length > 0) {
+							memcpy(value_pointer, pointer, length);
+							value_pointer += length;
+						}
+					}
+					break;
+				case ATTRIBUTE_VALUE:
+					end = scan_to(pointer, q, '&', q);
+					memcpy(value_pointer, pointer, end - pointer);
+					value_pointer += end - pointer;
+					break;
+				case BLOB:
+					if (device->version >= INDIGO_VERSION_2_0)
+						break;
+					end = scan_to(pointer, '<', '&', '&');
+					if (depth == 2) {
+						char *run = pointer;
+						while (run < end) {
+							if (value_pointer - value_buffer == BUFFER_SIZE)
+								blob_pointer = decode_blob_buffer(blob_pointer, value_buffer, &value_pointer);
+							long length = BUFFER_SIZE - (value_pointer - value_buffer);
+							if (length > end - run)
+								length = end - run;
+							memcpy(value_pointer, run, length);
+							value_pointer += length;
+							run += length;
+						}
+					}
+					break;
+				default:
+					break;
+			}
+			if (end != pointer) {
+				INDIGO_TRACE_PROTOCOL(indigo_trace("XML Parser: %ld characters %s", (long)(end - pointer), parser_state_name[state]));
+				pointer = end;
+				is_escaped = false;
+			}
+		}
 		while ((c = *pointer++) == 0) {
-			ssize_t count = (int)read(handle, (void *)buffer, (ssize_t)BUFFER_SIZE);
+			ssize_t count = (int)read_input(handle, inflater, (void *)buffer, (ssize_t)BUFFER_SIZE);
 			if (count <= 0) {
 				goto exit_loop;
 			}
@@ -1351,22 +1895,24 @@ void indigo_xml_parse(indigo_device *device, indigo_client *client) {
 					ssize_t bytes_needed = len % 4;
 					if(bytes_needed) bytes_needed = 4 - bytes_needed;
 					while (bytes_needed) {
-						count = (int)read(handle, (void *)buffer_end, bytes_needed);
+						count = (int)read_input(handle, inflater, (void *)buffer_end, bytes_needed);
 						if (count <= 0)
 							goto exit_loop;
 						len += count;
 						bytes_needed -= count;
 						buffer_end += count;
 					}
+					*buffer_end = 0;
 					blob_pointer += base64_decode_fast((unsigned char*)blob_pointer, (unsigned char*)pointer, len);
 					pointer += len;
 					blob_len -= len;
+					bool refill = blob_len > 0;
 					while(blob_len) {
 						len = ((BUFFER_SIZE) < blob_len) ? (BUFFER_SIZE) : blob_len;
 						ssize_t to_read = len;
 						char *ptr = buffer;
 						while(to_read) {
-							count = (int)read(handle, (void *)ptr, to_read);
+							count = (int)read_input(handle, inflater, (void *)ptr, to_read);
 							if (count <= 0)
 								goto exit_loop;
 							ptr += count;
@@ -1376,9 +1922,11 @@ void indigo_xml_parse(indigo_device *device, indigo_client *client) {
 						blob_len -= len;
 					}
 
-					handler = handler(BLOB, &context, NULL, (char *)blob_buffer, message);
-					pointer = buffer;
-					*pointer = 0;
+					handler = handler(BLOB, &context, NULL, (char *)blob_start, message);
+					if (refill) {
+						pointer = buffer;
+						*pointer = 0;
+					}
 					state = BLOB_END;
 					INDIGO_TRACE_PROTOCOL(indigo_trace("XML Parser: '%c' %d BLOB -> BLOB_END", c, depth));
 					break;
@@ -1386,22 +1934,17 @@ void indigo_xml_parse(indigo_device *device, indigo_client *client) {
 					if (c == '<') {
 						if (depth == 2) {
 							*value_pointer = 0;
-							blob_pointer += base64_decode_fast((unsigned char*)blob_pointer, (unsigned char*)value_buffer, (int)(value_pointer-value_buffer));
-							handler = handler(BLOB, &context, NULL, (char *)blob_buffer, message);
+							blob_pointer += base64_decode_fast_ws(blob_pointer, (unsigned char*)value_buffer, value_pointer - value_buffer, NULL);
+							handler = handler(BLOB, &context, NULL, (char *)blob_start, message);
 						}
 						state = TEXT1;
 						INDIGO_TRACE_PROTOCOL(indigo_trace("XML Parser: '%c' %d BLOB -> TEXT1", c, depth));
 						break;
-					} else if (c != '\n') {
+					} else {
 						if (depth == 2) {
-							if (value_pointer - value_buffer < BUFFER_SIZE) {
-								*value_pointer++ = c;
-							} else {
-								*value_pointer = 0;
-								blob_pointer += base64_decode_fast((unsigned char*)blob_pointer, (unsigned char*)value_buffer, (int)(value_pointer-value_buffer));
-								value_pointer = value_buffer;
-								*value_pointer++ = c;
-							}
+							if (value_pointer - value_buffer == BUFFER_SIZE)
+								blob_pointer = decode_blob_buffer(blob_pointer, value_buffer, &value_pointer);
+							*value_pointer++ = c;
 						}
 						INDIGO_TRACE_PROTOCOL(indigo_trace("XML Parser: '%c' %d BLOB", c, depth));
 					}
@@ -1419,19 +1962,52 @@ void indigo_xml_parse(indigo_device *device, indigo_client *client) {
 					state = END_TAG1;
 				} else if (c == '>') {
 					value_pointer = value_buffer;
-					if (handler == set_one_blob_vector_handler) {
-						blob_size = property->items[property->count-1].blob.size;
+					if (handler == set_one_blob_vector_handler || handler == set_one_array_vector_handler) {
+						indigo_item *item = property->items + property->count - 1;
+						if (handler == set_one_blob_vector_handler)
+							blob_size = item->blob.size;
+						else
+							blob_size = item->array.count * indigo_array_element_size(item->array.type);
 						if (blob_size > 0) {
 							state = BLOB;
-							if (blob_buffer != NULL) {
-								unsigned char *ptmp = realloc(blob_buffer, blob_size);
-								assert(ptmp != NULL);
-								blob_buffer = ptmp;
-							} else {
-								blob_buffer = malloc(blob_size);
-								assert(blob_buffer != NULL);
+							blob_start = blob_destination(&context, property, item, blob_size);
+							if (blob_start == NULL) {
+								if (handler == set_one_array_vector_handler) {
+									/* array value is owned by property buffer item */
+									blob_start = malloc(blob_size);
+									assert(blob_start != NULL);
+								} else {
+									if (blob_buffer != NULL) {
+										unsigned char *ptmp = realloc(blob_buffer, blob_size);
+										assert(ptmp != NULL);
+										blob_buffer = ptmp;
+									} else {
+										blob_buffer = malloc(blob_size);
+										assert(blob_buffer != NULL);
+									}
+									blob_start = blob_buffer;
+								}
+							}
+							blob_pointer = blob_start;
+							if (handler == set_one_blob_vector_handler && device->version >= INDIGO_VERSION_2_0 && ((indigo_adapter_context *)device->device_context)->raw_blobs) {
+								/* raw BLOB data follow immediately after the tag, size attribute is the length prefix */
+								long len = (long)(buffer_end - pointer);
+								if (len > blob_size)
+									len = blob_size;
+								memcpy(blob_pointer, pointer, len);
+								pointer += len;
+								blob_pointer += len;
+								long remaining = blob_size - len;
+								while (remaining > 0) {
+									ssize_t count = read_input(handle, inflater, (void *)blob_pointer, remaining);
+									if (count <= 0)
+										goto exit_loop;
+									blob_pointer += count;
+									remaining -= count;
+								}
+								handler = handler(BLOB, &context, NULL, (char *)blob_start, message);
+								state = BLOB_END;
 							}
-							blob_pointer = blob_buffer;
 						} else {
 							state = TEXT;
 						}
@@ -1480,97 +2056,148 @@ void indigo_xml_parse(indigo_device *device, indigo_client *client) {
 		}
 	}
 exit_loop:
-	while (true) {
+	while (context.count > 0) {
 		indigo_property *property = NULL;
-		int index;
-		for (index = 0; index < context.count; index++) {
-			property = context.properties[index];
-			if (property != NULL)
-				break;
+		for (int i = 0; property == NULL && i < context.size; i++) {
+			if (context.properties[i] != NULL)
+				property = context.properties[i]->property;
 		}
-		if (property == NULL)
-			break;
 		indigo_device remote_device;
 		strncpy(remote_device.name, property->device, INDIGO_NAME_SIZE);
 		remote_device.version = property->version;
 		indigo_property *all_properties = indigo_init_text_property(NULL, remote_device.name, "", "", "", INDIGO_OK_STATE, INDIGO_RO_PERM, 0);
 		indigo_delete_property(&remote_device, all_properties, NULL);
 		indigo_release_property(all_properties);
-		for (; index < context.count; index++) {
-			indigo_property *property = context.properties[index];
-			if (property != NULL && !strncmp(remote_device.name, property->device, INDIGO_NAME_SIZE)) {
+		for (int i = 0; i < context.size; i++) {
+			property_entry **link = context.properties + i;
+			while (*link != NULL) {
+				indigo_property *property = (*link)->property;
+				if (strncmp(remote_device.name, property->device, INDIGO_NAME_SIZE)) {
+					link = &(*link)->next;
+					continue;
+				}
 				if (property->type == INDIGO_BLOB_VECTOR) {
 					for (int i = 0; i < property->count; i++) {
 						void *blob = property->items[i].blob.value;
 						if (blob)
 							free(blob);
 					}
+				} else if (property->type == INDIGO_ARRAY_VECTOR) {
+					for (int i = 0; i < property->count; i++) {
+						void *array = property->items[i].array.value;
+						if (array)
+							free(array);
+					}
 				}
 				indigo_release_property(property);
-				context.properties[index] = NULL;
+				remove_property(&context, link);
 			}
 		}
 	}
+	if (context.properties != NULL)
+		free(context.properties);
 	if (blob_buffer != NULL)
 		free(blob_buffer);
+	if (inflater != NULL)
+		indigo_release_inflater(inflater);
 	free(buffer);
 	free(value_buffer);
 	close(handle);
 	indigo_log("XML Parser: parser finished");
 }
 
+/* Find first character to be escaped or end of string, 16 byte blocks are loaded only while fully in bounds */
+
+static inline const char *scan_escape(const char *pointer, const char *end) {
+#if defined(__SSE2__)
+	__m128i amp = _mm_set1_epi8('&'), lt = _mm_set1_epi8('<'), gt = _mm_set1_epi8('>'), quot = _mm_set1_epi8('"'), apos = _mm_set1_epi8('\'');
+	for (; end - pointer >= 16; pointer += 16) {
+		__m128i data = _mm_loadu_si128((const __m128i *)pointer);
+		__m128i match = _mm_or_si128(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(data, amp), _mm_cmpeq_epi8(data, lt)), _mm_or_si128(_mm_cmpeq_epi8(data, gt), _mm_cmpeq_epi8(data, quot))), _mm_cmpeq_epi8(data, apos));
+		int mask = _mm_movemask_epi8(match);
+		if (mask)
+			return pointer + __builtin_ctz(mask);
+	}
+#elif defined(__ARM_NEON)
+	uint8x16_t amp = vdupq_n_u8('&'), lt = vdupq_n_u8('<'), gt = vdupq_n_u8('>'), quot = vdupq_n_u8('"'), apos = vdupq_n_u8('\'');
+	for (; end - pointer >= 16; pointer += 16) {
+		uint8x16_t data = vld1q_u8((const uint8_t *)pointer);
+		uint8x16_t match = vorrq_u8(vorrq_u8(vorrq_u8(vceqq_u8(data, amp), vceqq_u8(data, lt)), vorrq_u8(vceqq_u8(data, gt), vceqq_u8(data, quot))), vceqq_u8(data, apos));
+		uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(match), 4)), 0);
+		if (mask)
+			return pointer + (__builtin_ctzll(mask) >> 2);
+	}
+#endif
+	char c;
+	while (pointer < end && (c = *pointer) != '&' && c != '<' && c != '>' && c != '"' && c != '\'')
+		pointer++;
+	return pointer;
+}
+
+static const char *xml_entity(char c, int *length) {
+	switch (c) {
+		case '&':
+			*length = 5;
+			return "&amp;";
+		case '<':
+			*length = 4;
+			return "&lt;";
+		case '>':
+			*length = 4;
+			return "&gt;";
+		case '"':
+			*length = 6;
+			return "&quot;";
+		default:
+			*length = 6;
+			return "&apos;";
+	}
+}
+
+bool indigo_buffer_xml_escape(indigo_output_buffer *buffer, const char *string) {
+	bool result = true;
+	const char *string_end = string + strlen(string);
+	while (true) {
+		const char *end = scan_escape(string, string_end);
+		if (end > string)
+			result = indigo_buffer_write(buffer, string, end - string) && result;
+		if (end == string_end)
+			return result;
+		int length;
+		const char *entity = xml_entity(*end, &length);
+		result = indigo_buffer_write(buffer, entity, length) && result;
+		string = end + 1;
+	}
+}
+
 char *indigo_xml_escape(char *string) {
-	if (strpbrk(string, "%<>\"'")) {
-		static char buffers[5][INDIGO_VALUE_SIZE];
-		static int	buffer_index = 0;
-		char *buffer = buffers[buffer_index = (buffer_index + 1) % 5];
-		char *in = string;
-		char *out = buffer;
-		char c;
-
-		while ((c = *in++) && out - buffer < INDIGO_VALUE_SIZE) {
-			switch (c) {
-				case '&':
-					*out++ = '&';
-					*out++ = 'a';
-					*out++ = 'm';
-					*out++ = 'p';
-					*out++ = ';';
-					break;
-				case '<':
-					*out++ = '&';
-					*out++ = 'l';
-					*out++ = 't';
-					*out++ = ';';
-					break;
-				case '>':
-					*out++ = '&';
-					*out++ = 'g';
-					*out++ = 't';
-					*out++ = ';';
-					break;
-				case '"':
-					*out++ = '&';
-					*out++ = 'q';
-					*out++ = 'u';
-					*out++ = 'o';
-					*out++ = 't';
-					*out++ = ';';
-					break;
-				case '\'':
-					*out++ = '&';
-					*out++ = 'a';
-					*out++ = 'p';
-					*out++ = 'o';
-					*out++ = 's';
-					*out++ = ';';
-					break;
-				default:
-					*out++ = c;
-			}
-		}
-		*out = 0;
-		return buffer;
+	const char *string_end = string + strlen(string);
+	const char *end = scan_escape(string, string_end);
+	if (end == string_end)
+		return string;
+	static __thread char buffers[5][INDIGO_VALUE_SIZE];
+	static __thread int buffer_index = 0;
+	char *buffer = buffers[buffer_index = (buffer_index + 1) % 5];
+	char *out = buffer;
+	char *limit = buffer + INDIGO_VALUE_SIZE - 1;
+	const char *in = string;
+	while (true) {
+		long length = end - in;
+		if (length > limit - out)
+			length = limit - out;
+		memcpy(out, in, length);
+		out += length;
+		if (end == string_end || out == limit)
+			break;
+		int entity_length;
+		const char *entity = xml_entity(*end, &entity_length);
+		if (entity_length > limit - out)
+			break;
+		memcpy(out, entity, entity_length);
+		out += entity_length;
+		in = end + 1;
+		end = scan_escape(in, string_end);
 	}
-	return string;
+	*out = 0;
+	return buffer;
 }
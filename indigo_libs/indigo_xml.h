@@ -28,19 +28,35 @@
 
 #include <stdio.h>
 #include "indigo_bus.h"
+#include "indigo_io.h"
 
 /** Use <enableBLOB>URL</enableBLOB> for remote INDIGO servers;
  */
 
 extern bool indigo_use_blob_urls;
 
+/** Request raw (not base64 encoded) BLOB data from remote INDIGO servers and grant it to INDIGO clients;
+ */
+
+extern bool indigo_use_raw_blobs;
+
+/** Request deflate compression of whole connection from remote INDIGO servers and grant it to INDIGO clients;
+ */
+
+extern bool indigo_use_compression;
+
 /** XML wire protocol parser.
  */
 extern void indigo_xml_parse(indigo_device *device, indigo_client *client);
 
-/** Escape XML string.
+/** Escape XML string (result is stored in one of 5 rotating thread local buffers if escaping is needed).
+ Deprecated, result is overwritten by the fifth next call, use indigo_buffer_xml_escape() instead.
  */
 extern char *indigo_xml_escape(char *string);
 
+/** Append XML escaped string to output buffer (strings without characters to escape are copied with single write).
+ */
+extern bool indigo_buffer_xml_escape(indigo_output_buffer *buffer, const char *string);
+
 #endif /* indigo_xml_h */
 
@@ -26,6 +26,7 @@
 #include <syslog.h>
 #include <assert.h>
 #include <signal.h>
+#include <pthread.h>
 #include <dns_sd.h>
 #include <libgen.h>
 #include <arpa/inet.h>
@@ -88,8 +89,27 @@ driver_entry_point static_drivers[] = {
 	NULL
 };
 
+static struct {
+	const char *name;
+	uint16_t usb_vendors[INDIGO_MAX_USB_VENDORS];
+} usb_drivers[] = {
+	{ "indigo_ccd_sx", { 0x1278 } },
+	{ "indigo_wheel_sx", { 0x1278 } },
+	{ "indigo_ccd_ssag", { 0x1856, 0x1618 } },
+	{ "indigo_ccd_asi", { 0x03c3 } },
+	{ "indigo_wheel_asi", { 0x03c3 } },
+	{ "indigo_ccd_atik", { 0x20e7, 0x04b4 } },
+	{ "indigo_wheel_atik", { 0x04d8 } },
+	{ "indigo_ccd_qhy", { 0x1618, 0x16c0 } },
+	{ "indigo_focuser_fcusb", { 0x134a } },
+	{ "indigo_wheel_fli", { 0x0f18 } },
+	{ "indigo_focuser_fli", { 0x0f18 } },
+	{ NULL }
+};
+
 static int first_driver = 2;
 static indigo_property *drivers_property;
+static pthread_mutex_t drivers_mutex = PTHREAD_MUTEX_INITIALIZER; /* drivers_property is rewritten by client threads and on demand activation */
 static indigo_property *servers_property;
 static indigo_property *load_property;
 static indigo_property *unload_property;
@@ -105,6 +125,7 @@ static bool use_sigkill = false;
 static bool server_startup = true;
 static bool use_bonjour = true;
 static bool use_control_panel = true;
+static bool on_demand = false;
 
 static indigo_result attach(indigo_device *device);
 static indigo_result enumerate_properties(indigo_device *device, indigo_client *client, indigo_property *property);
@@ -142,13 +163,55 @@ static void server_callback(int count) {
 	}
 }
 
+static const uint16_t *usb_vendors(const char *name) {
+	char driver_name[INDIGO_NAME_SIZE];
+	strncpy(driver_name, name, INDIGO_NAME_SIZE);
+	char *entry_point_name = basename(driver_name);
+	char *cp = strchr(entry_point_name, '.');
+	if (cp)
+		*cp = 0;
+	for (int i = 0; usb_drivers[i].name; i++)
+		if (!strcmp(usb_drivers[i].name, entry_point_name))
+			return usb_drivers[i].usb_vendors;
+	return NULL;
+}
+
+static indigo_driver_entry *find_driver(const char *description) {
+	for (int i = 0; i < INDIGO_MAX_DRIVERS; i++)
+		if (*indigo_available_drivers[i].name && !strcmp(indigo_available_drivers[i].description, description))
+			return &indigo_available_drivers[i];
+	return NULL;
+}
+
+static int populate_drivers_property(indigo_driver_entry *driver) {
+	int index = -1;
+	drivers_property->count = 0;
+	for (int i = 0; i < INDIGO_MAX_DRIVERS; i++)
+		if (*indigo_available_drivers[i].name) {
+			if (&indigo_available_drivers[i] == driver)
+				index = drivers_property->count;
+			indigo_init_switch_item(&drivers_property->items[drivers_property->count++], indigo_available_drivers[i].description, indigo_available_drivers[i].description, indigo_available_drivers[i].initialized);
+		}
+	return index;
+}
+
+static void driver_activated(indigo_driver_entry *driver) {
+	/* item name changes from driver name to its description once it is loaded */
+	pthread_mutex_lock(&drivers_mutex);
+	indigo_delete_property(&server_device, drivers_property, NULL);
+	populate_drivers_property(driver);
+	drivers_property->state = INDIGO_OK_STATE;
+	indigo_define_property(&server_device, drivers_property, "Driver %s activated", driver->description);
+	pthread_mutex_unlock(&drivers_mutex);
+}
+
 static indigo_result attach(indigo_device *device) {
 	assert(device != NULL);
 	drivers_property = indigo_init_switch_property(NULL, server_device.name, "DRIVERS", "Main", "Active drivers", INDIGO_IDLE_STATE, INDIGO_RW_PERM, INDIGO_ANY_OF_MANY_RULE, INDIGO_MAX_DRIVERS);
-	drivers_property->count = 0;
-	for (int i = 0; i < INDIGO_MAX_DRIVERS; i++)
-		if (indigo_available_drivers[i].driver != NULL)
-			indigo_init_switch_item(&drivers_property->items[drivers_property->count++], indigo_available_drivers[i].description, indigo_available_drivers[i].description, true);
+	populate_drivers_property(NULL);
+	if (!on_demand)
+		for (int i = 0; i < drivers_property->count; i++)
+			drivers_property->items[i].sw.value = true;
 	servers_property = indigo_init_light_property(NULL, server_device.name, "SERVERS", "Main", "Active servers", INDIGO_IDLE_STATE, 2 * INDIGO_MAX_SERVERS);
 	servers_property->count = 0;
 	for (int i = 0; i < INDIGO_MAX_SERVERS; i++) {
@@ -174,7 +237,9 @@ static indigo_result attach(indigo_device *device) {
 	indigo_init_text_item(&unload_property->items[0], "DRIVER", "Unload driver", "");
 	restart_property = indigo_init_switch_property(NULL, server_device.name, "RESTART", "Main", "Restart", INDIGO_IDLE_STATE, INDIGO_RW_PERM, INDIGO_ANY_OF_MANY_RULE, 1);
 	indigo_init_switch_item(restart_property->items, "RESTART", "Restart server", false);
-	if (indigo_load_properties(device, false) == INDIGO_FAILED)
+	if (on_demand)
+		drivers_property->state = INDIGO_OK_STATE;
+	else if (indigo_load_properties(device, false) == INDIGO_FAILED)
 		change_property(device, NULL, drivers_property);
 	INDIGO_LOG(indigo_log("%s attached", device->name));
 	return INDIGO_OK;
@@ -182,7 +247,9 @@ static indigo_result attach(indigo_device *device) {
 
 static indigo_result enumerate_properties(indigo_device *device, indigo_client *client, indigo_property *property) {
 	assert(device != NULL);
+	pthread_mutex_lock(&drivers_mutex);
 	indigo_define_property(device, drivers_property, NULL);
+	pthread_mutex_unlock(&drivers_mutex);
 	if (servers_property->count > 0)
 		indigo_define_property(device, servers_property, NULL);
 	indigo_define_property(device, load_property, NULL);
@@ -196,40 +263,61 @@ static indigo_result change_property(indigo_device *device, indigo_client *clien
 	assert(property != NULL);
 	if (indigo_property_match(drivers_property, property)) {
 	// -------------------------------------------------------------------------------- DRIVERS
+		pthread_mutex_lock(&drivers_mutex);
 		indigo_property_copy_values(drivers_property, property, false);
-		for (int i = 0; i < drivers_property->count; i++)
+		bool redefine = false;
+		for (int i = 0; i < drivers_property->count; i++) {
+			indigo_driver_entry *driver = find_driver(drivers_property->items[i].name);
+			if (driver == NULL)
+				continue;
 			if (drivers_property->items[i].sw.value) {
-				indigo_available_drivers[i].initialized = indigo_available_drivers[i].driver(INDIGO_DRIVER_INIT, NULL) == INDIGO_OK;				
-			} else {
-				indigo_available_drivers[i].driver(INDIGO_DRIVER_SHUTDOWN, NULL);
-				indigo_available_drivers[i].initialized = false;
+				bool loaded = driver->driver != NULL;
+				indigo_activate_driver(driver);
+				redefine |= !loaded && driver->driver != NULL;
+			} else if (driver->driver != NULL) {
+				driver->driver(INDIGO_DRIVER_SHUTDOWN, NULL);
+				driver->initialized = false;
 			}
+		}
 		drivers_property->state = INDIGO_OK_STATE;
-		indigo_update_property(device, drivers_property, NULL);
+		if (redefine) {
+			indigo_delete_property(device, drivers_property, NULL);
+			populate_drivers_property(NULL);
+			indigo_define_property(device, drivers_property, NULL);
+		} else {
+			indigo_update_property(device, drivers_property, NULL);
+		}
 		int handle = 0;
 		indigo_save_property(device, &handle, drivers_property);
 		close(handle);
+		pthread_mutex_unlock(&drivers_mutex);
 	} else if (indigo_property_match(load_property, property)) {
 		// -------------------------------------------------------------------------------- LOAD
 		indigo_property_copy_values(load_property, property, false);
 		if (*load_property->items[0].text.value) {
-			if (indigo_load_driver(load_property->items[0].text.value, true, NULL) == INDIGO_OK) {
-				indigo_delete_property(device, drivers_property, NULL);
-				drivers_property->count = 0;
-				for (int i = 0; i < INDIGO_MAX_DRIVERS; i++)
-					if (indigo_available_drivers[i].driver != NULL)
-						indigo_init_switch_item(&drivers_property->items[drivers_property->count++], indigo_available_drivers[i].description, indigo_available_drivers[i].description, indigo_available_drivers[i].initialized);
-				indigo_define_property(device, drivers_property, NULL);
+			indigo_driver_entry *driver = NULL;
+			pthread_mutex_lock(&drivers_mutex);
+			int count = drivers_property->count;
+			if (indigo_load_driver(load_property->items[0].text.value, true, &driver) == INDIGO_OK) {
+				int index = populate_drivers_property(driver);
+				if (drivers_property->count == count) {
+					/* registered driver was loaded in place */
+					indigo_delete_property(device, drivers_property, NULL);
+					indigo_define_property(device, drivers_property, NULL);
+				} else {
+					indigo_define_property_items(device, drivers_property, index, 1, NULL);
+				}
 				load_property->state = INDIGO_OK_STATE;
 				char *name = basename(load_property->items[0].text.value);
 				for (int i = 0; i < INDIGO_MAX_DRIVERS; i++)
-					if (indigo_available_drivers[i].driver != NULL && !strcmp(name, indigo_available_drivers[i].name)) {
+					if (*indigo_available_drivers[i].name && !strcmp(name, indigo_available_drivers[i].name)) {
 						indigo_update_property(device, load_property, "Driver %s (%s) loaded", name, indigo_available_drivers[i].description);
 					}
 			} else {
 				load_property->state = INDIGO_ALERT_STATE;
 				indigo_update_property(device, load_property, indigo_last_message);
 			}
+			pthread_mutex_unlock(&drivers_mutex);
 		}
 	} else if (indigo_property_match(unload_property, property)) {
 		// -------------------------------------------------------------------------------- UNLOAD
@@ -242,19 +330,25 @@ static indigo_result change_property(indigo_device *device, indigo_client *clien
 					break;
 				}
 			}
+			int index = -1;
+			pthread_mutex_lock(&drivers_mutex);
+			if (driver != NULL) {
+				for (int i = 0; i < drivers_property->count; i++)
+					if (!strcmp(drivers_property->items[i].name, driver->description)) {
+						index = i;
+						break;
+					}
+			}
 			if (driver != NULL && indigo_remove_driver(driver) == INDIGO_OK) {
-				indigo_delete_property(device, drivers_property, NULL);
-				drivers_property->count = 0;
-				for (int i = 0; i < INDIGO_MAX_DRIVERS; i++)
-					if (indigo_available_drivers[i].driver != NULL)
-						indigo_init_switch_item(&drivers_property->items[drivers_property->count++], indigo_available_drivers[i].description, indigo_available_drivers[i].description, indigo_available_drivers[i].initialized);
-				indigo_define_property(device, drivers_property, NULL);
+				if (index >= 0)
+					indigo_delete_property_items(device, drivers_property, index, 1, NULL);
 				load_property->state = INDIGO_OK_STATE;
 				indigo_update_property(device, unload_property, "Driver %s unloaded", unload_property->items[0].text.value);
 			} else {
 				load_property->state = INDIGO_ALERT_STATE;
 				indigo_update_property(device, unload_property, indigo_last_message);
 			}
+			pthread_mutex_unlock(&drivers_mutex);
 		}
 	} else if (indigo_property_match(restart_property, property)) {
 	// -------------------------------------------------------------------------------- RESTART
@@ -286,6 +380,15 @@ static void server_main(int argc, const char * argv[]) {
 
 	indigo_start();
 
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-o") || !strcmp(argv[i], "--on-demand"))
+			on_demand = true;
+		else if (!strcmp(argv[i], "--enable-compression"))
+			indigo_use_compression = true;
+		else if (!strcmp(argv[i], "--disable-raw-blobs"))
+			indigo_use_raw_blobs = false;
+	}
+
 	for (int i = 1; i < argc; i++) {
 		if ((!strcmp(argv[i], "-p") || !strcmp(argv[i], "--port")) && i < argc - 1) {
 			indigo_server_tcp_port = atoi(argv[i + 1]);
@@ -318,7 +421,10 @@ static void server_main(int argc, const char * argv[]) {
 		} else if (!strcmp(argv[i], "-u-") || !strcmp(argv[i], "--disable-blob-urls")) {
 			indigo_use_blob_urls = false;
 		} else if(argv[i][0] != '-') {
-			indigo_load_driver(argv[i], false, NULL);
+			if (on_demand)
+				indigo_register_driver(argv[i], usb_vendors(argv[i]), NULL);
+			else
+				indigo_load_driver(argv[i], false, NULL);
 		}
 	}
 
@@ -326,10 +432,15 @@ static void server_main(int argc, const char * argv[]) {
 		indigo_server_add_resource("/ctrl", ctrl, sizeof(ctrl), "text/html");
 
 	for (int i = first_driver; static_drivers[i]; i++) {
-		indigo_add_driver(static_drivers[i], false, NULL);
+		indigo_driver_entry *driver = NULL;
+		if (indigo_add_driver(static_drivers[i], false, &driver) == INDIGO_OK && on_demand && usb_vendors(driver->name))
+			memcpy(driver->usb_vendors, usb_vendors(driver->name), sizeof(driver->usb_vendors));
 	}
 
-	indigo_attach_device(&server_device);	
+	indigo_attach_device(&server_device);
+	if (on_demand)
+		indigo_start_on_demand_activation(driver_activated);
+
 	indigo_server_start(server_callback);
 
 #ifdef INDIGO_MACOS
@@ -390,7 +501,7 @@ int main(int argc, const char * argv[]) {
 			indigo_use_syslog = true;
 		} else if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help")) {
 			printf("%s [-h|--help]\n", argv[0]);
-			printf("%s [--|--do-not-fork] [-l|--use-syslog] [-s|--enable-simulators] [-p|--port port] [-u-|--disable-blob-urls] [-b|--bonjour name] [-b-|--disable-bonjour] [-c-|--disable-control-panel] [-v|--enable-log] [-vv|--enable-debug] [-vvv|--enable-trace] [-r|--remote-server host:port] [-i|--indi-driver driver_executable] indigo_driver_name indigo_driver_name ...\n", argv[0]);
+			printf("%s [--|--do-not-fork] [-l|--use-syslog] [-s|--enable-simulators] [-p|--port port] [-u-|--disable-blob-urls] [--disable-raw-blobs] [--enable-compression] [-b|--bonjour name] [-b-|--disable-bonjour] [-c-|--disable-control-panel] [-o|--on-demand] [-v|--enable-log] [-vv|--enable-debug] [-vvv|--enable-trace] [-r|--remote-server host:port] [-i|--indi-driver driver_executable] indigo_driver_name indigo_driver_name ...\n", argv[0]);
 			return 0;
 		} else {
 			server_argv[server_argc++] = argv[i];
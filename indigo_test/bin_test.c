@@ -0,0 +1,565 @@
+// Copyright (c) 2016 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 Build 0 - PoC by Peter Polakovic <peter.polakovic@cloudmakers.eu>
+
+// Binary wire protocol round-trip test: properties are serialized by device side adapter into a file and decoded back by the test
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "indigo_bus.h"
+#include "indigo_bin.h"
+#include "indigo_driver_bin.h"
+
+#define TEST_DEVICE			"BIN Test"
+#define PROPERTY_COUNT	6
+#define PROPERTY_SIZE		(sizeof(indigo_property) + INDIGO_MAX_ITEMS * sizeof(indigo_item))
+
+static const char *text_values[] = {
+	"short",
+	"0123456789012345678901234567890",
+	"01234567890123456789012345678901",
+	"/home/observer/images/M31_light_0001_long_name.fits",
+	"binary protocol sends <tags> & \"quotes\" unescaped",
+	""
+};
+
+/* messages sent after updates, NULL message is sent as empty string */
+
+static const char *messages[] = { NULL, "Exposure done" };
+
+static const uint8_t preamble[] = { INDIGO_BIN_MAGIC, 'I', 'B', INDIGO_BIN_PROTOCOL_VERSION };
+
+typedef struct {
+	bool definition;
+	indigo_property *property;
+	char message[INDIGO_VALUE_SIZE];
+} record;
+
+static indigo_property *properties[PROPERTY_COUNT];
+static unsigned char blob_data[10000];
+static float array_data[2][3][4];
+static record records[64];
+static int record_count = 0, replay_count = 0, message_count = 0;
+static int checks = 0, failures = 0;
+
+static indigo_result test_enumerate_properties(indigo_device *device, indigo_client *client, indigo_property *property) {
+	for (int i = 0; i < PROPERTY_COUNT; i++)
+		indigo_define_property(device, properties[i], NULL);
+	return INDIGO_OK;
+}
+
+static indigo_device test_device = {
+	TEST_DEVICE, NULL, NULL, INDIGO_OK, INDIGO_VERSION_CURRENT,
+	NULL,
+	test_enumerate_properties,
+	NULL,
+	NULL
+};
+
+/* recorder keeps deep copy of everything broadcasted by test device */
+
+static void record_property(bool definition, indigo_property *property, const char *message) {
+	assert(record_count < sizeof(records) / sizeof(record));
+	record *r = records + record_count++;
+	int size = sizeof(indigo_property) + property->count * sizeof(indigo_item);
+	r->definition = definition;
+	r->property = malloc(size);
+	memcpy(r->property, property, size);
+	strcpy(r->message, message ? message : "");
+	for (int i = 0; i < property->count; i++) {
+		indigo_item *item = r->property->items + i;
+		if (property->type == INDIGO_BLOB_VECTOR && item->blob.value != NULL) {
+			item->blob.value = malloc(item->blob.size);
+			memcpy(item->blob.value, property->items[i].blob.value, item->blob.size);
+		} else if (property->type == INDIGO_ARRAY_VECTOR && item->array.value != NULL) {
+			long size = item->array.count * indigo_array_element_size(item->array.type);
+			item->array.value = malloc(size);
+			memcpy(item->array.value, property->items[i].array.value, size);
+		}
+	}
+}
+
+static indigo_result recorder_define_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
+	record_property(true, property, message);
+	return INDIGO_OK;
+}
+
+static indigo_result recorder_update_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
+	record_property(false, property, message);
+	return INDIGO_OK;
+}
+
+static indigo_client recorder_client = {
+	"BIN Test Recorder", NULL, INDIGO_OK, INDIGO_VERSION_CURRENT, INDIGO_ENABLE_BLOB_ALSO,
+	NULL,
+	recorder_define_property,
+	recorder_update_property,
+	NULL,
+	NULL,
+	NULL
+};
+
+/* everything decoded from the stream is compared with recorded data */
+
+static void check(bool condition, indigo_property *property, indigo_item *item, const char *what) {
+	checks++;
+	if (!condition) {
+		failures++;
+		indigo_error("%s.%s.%s: %s mismatch", property->device, property->name, item ? item->name : "", what);
+	}
+}
+
+static void compare_property(bool definition, indigo_property *property, const char *message) {
+	if (replay_count >= record_count) {
+		check(false, property, NULL, "unexpected message");
+		return;
+	}
+	record *r = records + replay_count++;
+	indigo_property *original = r->property;
+	check(r->definition == definition, property, NULL, "message type");
+	check(!strcmp(r->message, message), property, NULL, "message");
+	if (strcmp(original->device, property->device) || strcmp(original->name, property->name) || original->type != property->type || original->count != property->count || original->state != property->state) {
+		check(false, property, NULL, "property");
+		return;
+	}
+	if (definition) {
+		check(!strcmp(original->group, property->group) && !strcmp(original->label, property->label), property, NULL, "group or label");
+		check(original->perm == property->perm && original->rule == property->rule, property, NULL, "perm or rule");
+	}
+	for (int i = 0; i < property->count; i++) {
+		indigo_item *item = property->items + i, *original_item = original->items + i;
+		check(!strcmp(item->name, original_item->name), property, item, "name");
+		if (definition)
+			check(!strcmp(item->label, original_item->label), property, item, "label");
+		switch (property->type) {
+			case INDIGO_TEXT_VECTOR:
+				check(!strcmp(item->text.value, original_item->text.value), property, item, "text");
+				break;
+			case INDIGO_NUMBER_VECTOR:
+				if (definition)
+					check(!strcmp(item->number.format, original_item->number.format) && item->number.min == original_item->number.min && item->number.max == original_item->number.max && item->number.step == original_item->number.step, property, item, "number format or range");
+				check(item->number.target == original_item->number.target && item->number.value == original_item->number.value, property, item, "number");
+				break;
+			case INDIGO_SWITCH_VECTOR:
+				check(item->sw.value == original_item->sw.value, property, item, "switch");
+				break;
+			case INDIGO_LIGHT_VECTOR:
+				check(item->light.value == original_item->light.value, property, item, "light");
+				break;
+			case INDIGO_BLOB_VECTOR:
+				if (definition)
+					break;
+				if (property->state == INDIGO_OK_STATE)
+					check(!strcmp(item->blob.format, original_item->blob.format) && item->blob.size == original_item->blob.size && item->blob.value != NULL && !memcmp(item->blob.value, original_item->blob.value, item->blob.size), property, item, "BLOB");
+				else
+					check(item->blob.value == NULL, property, item, "BLOB");
+				break;
+			case INDIGO_ARRAY_VECTOR:
+				check(item->array.type == original_item->array.type, property, item, "array type");
+				if (!definition)
+					check(item->array.count == original_item->array.count && item->array.rank == original_item->array.rank && !memcmp(item->array.shape, original_item->array.shape, item->array.rank * sizeof(int)) && !memcmp(item->array.value, original_item->array.value, item->array.count * indigo_array_element_size(item->array.type)), property, item, "array");
+				break;
+		}
+	}
+}
+
+/* decoder of server messages as described in indigo_bin.h */
+
+typedef struct {
+	const uint8_t *pointer, *end;
+	int name_count;
+	char names[INDIGO_BIN_MAX_NAMES][INDIGO_NAME_SIZE];
+} decoder;
+
+static bool decode_byte(decoder *d, uint8_t *value) {
+	if (d->pointer >= d->end)
+		return false;
+	*value = *d->pointer++;
+	return true;
+}
+
+static bool decode_varint(decoder *d, uint64_t *value) {
+	*value = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		uint8_t byte;
+		if (!decode_byte(d, &byte))
+			return false;
+		*value |= (uint64_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+static bool decode_raw(decoder *d, void *value, uint64_t size) {
+	if ((uint64_t)(d->end - d->pointer) < size)
+		return false;
+	memcpy(value, d->pointer, size);
+	d->pointer += size;
+	return true;
+}
+
+static bool decode_string(decoder *d, char *string, long size) {
+	uint64_t length;
+	if (!decode_varint(d, &length) || length >= (uint64_t)size || !decode_raw(d, string, length))
+		return false;
+	string[length] = 0;
+	return true;
+}
+
+static bool decode_name(decoder *d, char *name) {
+	uint64_t reference;
+	if (!decode_varint(d, &reference))
+		return false;
+	if (reference > 0) {
+		if (reference > (uint64_t)d->name_count)
+			return false;
+		strcpy(name, d->names[reference - 1]);
+		return true;
+	}
+	if (!decode_string(d, name, INDIGO_NAME_SIZE))
+		return false;
+	if (d->name_count < INDIGO_BIN_MAX_NAMES)
+		strcpy(d->names[d->name_count++], name);
+	return true;
+}
+
+static bool decode_double(decoder *d, double *value) {
+	uint64_t bits;
+	if (!decode_raw(d, &bits, 8))
+		return false;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	bits = __builtin_bswap64(bits);
+#endif
+	memcpy(value, &bits, 8);
+	return true;
+}
+
+static bool decode_flags(decoder *d, char *message) {
+	uint8_t flags;
+	*message = 0;
+	if (!decode_byte(d, &flags))
+		return false;
+	return (flags & INDIGO_BIN_FLAG_MESSAGE) == 0 || decode_string(d, message, INDIGO_VALUE_SIZE);
+}
+
+static bool decode_count(decoder *d, indigo_property *property) {
+	uint64_t count;
+	if (!decode_varint(d, &count) || count > INDIGO_MAX_ITEMS)
+		return false;
+	property->count = (int)count;
+	return true;
+}
+
+static bool decode_def_vector(decoder *d, indigo_property *property, char *message) {
+	uint8_t type, perm, state, rule;
+	if (!decode_byte(d, &type) || !decode_name(d, property->device) || !decode_name(d, property->name) || !decode_name(d, property->group) || !decode_string(d, property->label, INDIGO_VALUE_SIZE))
+		return false;
+	if (!decode_byte(d, &perm) || !decode_byte(d, &state) || !decode_byte(d, &rule) || !decode_flags(d, message) || !decode_count(d, property))
+		return false;
+	property->type = type;
+	property->perm = perm;
+	property->state = state;
+	property->rule = rule;
+	for (int i = 0; i < property->count; i++) {
+		indigo_item *item = property->items + i;
+		uint8_t value;
+		if (!decode_name(d, item->name) || !decode_string(d, item->label, INDIGO_VALUE_SIZE))
+			return false;
+		switch (property->type) {
+			case INDIGO_TEXT_VECTOR:
+				if (!decode_string(d, item->text.value, INDIGO_VALUE_SIZE))
+					return false;
+				break;
+			case INDIGO_NUMBER_VECTOR:
+				if (!decode_name(d, item->number.format) || !decode_double(d, &item->number.min) || !decode_double(d, &item->number.max) || !decode_double(d, &item->number.step) || !decode_double(d, &item->number.target) || !decode_double(d, &item->number.value))
+					return false;
+				break;
+			case INDIGO_SWITCH_VECTOR:
+				if (!decode_byte(d, &value))
+					return false;
+				item->sw.value = value != 0;
+				break;
+			case INDIGO_LIGHT_VECTOR:
+				if (!decode_byte(d, &value))
+					return false;
+				item->light.value = value;
+				break;
+			case INDIGO_BLOB_VECTOR:
+				break;
+			case INDIGO_ARRAY_VECTOR:
+				if (!decode_byte(d, &value))
+					return false;
+				item->array.type = value;
+				break;
+			default:
+				return false;
+		}
+	}
+	return true;
+}
+
+static bool decode_set_vector(decoder *d, indigo_property *property, char *message) {
+	uint8_t type, state;
+	if (!decode_byte(d, &type) || !decode_name(d, property->device) || !decode_name(d, property->name) || !decode_byte(d, &state) || !decode_flags(d, message) || !decode_count(d, property))
+		return false;
+	property->type = type;
+	property->state = state;
+	for (int i = 0; i < property->count; i++) {
+		indigo_item *item = property->items + i;
+		uint8_t value;
+		uint64_t size;
+		if (!decode_name(d, item->name))
+			return false;
+		switch (property->type) {
+			case INDIGO_TEXT_VECTOR:
+				if (!decode_string(d, item->text.value, INDIGO_VALUE_SIZE))
+					return false;
+				break;
+			case INDIGO_NUMBER_VECTOR:
+				if (!decode_double(d, &item->number.target) || !decode_double(d, &item->number.value))
+					return false;
+				break;
+			case INDIGO_SWITCH_VECTOR:
+				if (!decode_byte(d, &value))
+					return false;
+				item->sw.value = value != 0;
+				break;
+			case INDIGO_LIGHT_VECTOR:
+				if (!decode_byte(d, &value))
+					return false;
+				item->light.value = value;
+				break;
+			case INDIGO_BLOB_VECTOR:
+				if (!decode_byte(d, &value))
+					return false;
+				if (value == INDIGO_BIN_BLOB_RAW) {
+					if (!decode_name(d, item->blob.format) || !decode_varint(d, &size) || size > (uint64_t)(d->end - d->pointer))
+						return false;
+					item->blob.size = size;
+					item->blob.value = malloc(size);
+					decode_raw(d, item->blob.value, size);
+				} else if (value == INDIGO_BIN_BLOB_URL) {
+					if (!decode_name(d, item->blob.format) || !decode_string(d, item->blob.url, INDIGO_VALUE_SIZE))
+						return false;
+				} else if (value != INDIGO_BIN_BLOB_NONE) {
+					return false;
+				}
+				break;
+			case INDIGO_ARRAY_VECTOR: {
+				uint64_t rank, dimension;
+				if (!decode_byte(d, &value) || !decode_varint(d, &rank) || rank > INDIGO_MAX_ARRAY_RANK)
+					return false;
+				item->array.type = value;
+				item->array.rank = (int)rank;
+				for (int j = 0; j < item->array.rank; j++) {
+					if (!decode_varint(d, &dimension))
+						return false;
+					item->array.shape[j] = (int)dimension;
+				}
+				int element_size = indigo_array_element_size(item->array.type);
+				if (!decode_varint(d, &size) || size * element_size > (uint64_t)(d->end - d->pointer))
+					return false;
+				item->array.count = size;
+				item->array.value = malloc(size * element_size);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+				for (uint64_t k = 0; k < size; k++)
+					for (int j = 0; j < element_size; j++)
+						((uint8_t *)item->array.value)[k * element_size + j] = d->pointer[k * element_size + element_size - 1 - j];
+				d->pointer += size * element_size;
+#else
+				decode_raw(d, item->array.value, size * element_size);
+#endif
+				break;
+			}
+			default:
+				return false;
+		}
+	}
+	return true;
+}
+
+static void release_values(indigo_property *property) {
+	for (int i = 0; i < property->count; i++) {
+		indigo_item *item = property->items + i;
+		if (property->type == INDIGO_BLOB_VECTOR && item->blob.value != NULL)
+			free(item->blob.value);
+		else if (property->type == INDIGO_ARRAY_VECTOR && item->array.value != NULL)
+			free(item->array.value);
+	}
+}
+
+static void decode_stream(int stream) {
+	long size = lseek(stream, 0, SEEK_END);
+	uint8_t *data = malloc(size);
+	assert(data != NULL);
+	lseek(stream, 0, SEEK_SET);
+	if (read(stream, data, size) != size) {
+		check(false, &INDIGO_ALL_PROPERTIES, NULL, "stream size");
+		free(data);
+		return;
+	}
+	/* no broadcast may get ahead of the preamble echo */
+	check(size >= sizeof(preamble) && !memcmp(data, preamble, sizeof(preamble)), &INDIGO_ALL_PROPERTIES, NULL, "preamble");
+	decoder *d = malloc(sizeof(decoder));
+	assert(d != NULL);
+	d->pointer = data + sizeof(preamble);
+	d->end = data + size;
+	d->name_count = 0;
+	indigo_property *property = malloc(PROPERTY_SIZE);
+	assert(property != NULL);
+	char message[INDIGO_VALUE_SIZE];
+	while (d->pointer < d->end) {
+		uint8_t type;
+		bool result = false;
+		memset(property, 0, PROPERTY_SIZE);
+		decode_byte(d, &type);
+		if (type == INDIGO_BIN_MESSAGE) {
+			if (!decode_name(d, property->device) || !decode_string(d, message, INDIGO_VALUE_SIZE)) {
+				check(false, property, NULL, "protocol");
+				break;
+			}
+			check(message_count < sizeof(messages) / sizeof(char *) && !strcmp(property->device, TEST_DEVICE) && !strcmp(message, messages[message_count] ? messages[message_count] : ""), property, NULL, "message");
+			message_count++;
+			continue;
+		}
+		if (type == INDIGO_BIN_DEF_VECTOR)
+			result = decode_def_vector(d, property, message);
+		else if (type == INDIGO_BIN_SET_VECTOR)
+			result = decode_set_vector(d, property, message);
+		if (!result) {
+			check(false, property, NULL, "protocol");
+			release_values(property);
+			break;
+		}
+		compare_property(type == INDIGO_BIN_DEF_VECTOR, property, message);
+		release_values(property);
+	}
+	free(property);
+	free(d);
+	free(data);
+}
+
+static void init_properties() {
+	int text_count = sizeof(text_values) / sizeof(char *);
+	properties[0] = indigo_init_text_property(NULL, TEST_DEVICE, "TEXT", "Main", "Text", INDIGO_OK_STATE, INDIGO_RW_PERM, text_count);
+	for (int i = 0; i < text_count; i++) {
+		char name[INDIGO_NAME_SIZE];
+		sprintf(name, "TEXT_%d", i);
+		indigo_init_text_item(properties[0]->items + i, name, name, "%s", text_values[i]);
+	}
+	properties[1] = indigo_init_number_property(NULL, TEST_DEVICE, "NUMBER", "Main", "Number", INDIGO_OK_STATE, INDIGO_RW_PERM, 3);
+	indigo_init_number_item(properties[1]->items, "NUMBER_0", "Number 0", -1e10, 1e10, 0, 0.1);
+	indigo_init_number_item(properties[1]->items + 1, "NUMBER_1", "Number 1", -1e10, 1e10, 0.5, -1.0 / 3.0);
+	indigo_init_number_item(properties[1]->items + 2, "NUMBER_2", "Number 2", -1e30, 1e30, 0, 6.02214076e23);
+	strcpy(properties[1]->items[2].number.format, "%12.6e");
+	properties[2] = indigo_init_switch_property(NULL, TEST_DEVICE, "SWITCH", "Main", "Switch", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_ANY_OF_MANY_RULE, 2);
+	indigo_init_switch_item(properties[2]->items, "SWITCH_0", "Switch 0", false);
+	indigo_init_switch_item(properties[2]->items + 1, "SWITCH_1", "Switch 1", true);
+	properties[3] = indigo_init_light_property(NULL, TEST_DEVICE, "LIGHT", "Status", "Light", INDIGO_BUSY_STATE, 2);
+	indigo_init_light_item(properties[3]->items, "LIGHT_0", "Light 0", INDIGO_BUSY_STATE);
+	indigo_init_light_item(properties[3]->items + 1, "LIGHT_1", "Light 1", INDIGO_ALERT_STATE);
+	properties[4] = indigo_init_blob_property(NULL, TEST_DEVICE, "BLOB", "Image", "BLOB", INDIGO_OK_STATE, 2);
+	indigo_init_blob_item(properties[4]->items, "BLOB_0", "BLOB 0");
+	indigo_init_blob_item(properties[4]->items + 1, "BLOB_1", "BLOB 1");
+	for (int i = 0; i < sizeof(blob_data); i++)
+		blob_data[i] = (unsigned char)(i * 7 + (i >> 8));
+	strcpy(properties[4]->items[0].blob.format, ".raw");
+	properties[4]->items[0].blob.value = blob_data;
+	properties[4]->items[0].blob.size = sizeof(blob_data);
+	strcpy(properties[4]->items[1].blob.format, ".fits");
+	properties[4]->items[1].blob.value = blob_data + 1000;
+	properties[4]->items[1].blob.size = 1;
+	properties[5] = indigo_init_array_property(NULL, TEST_DEVICE, "ARRAY", "Image", "Array", INDIGO_OK_STATE, 2);
+	indigo_init_array_item(properties[5]->items, "ARRAY_0", "Array 0", INDIGO_ARRAY_FLOAT);
+	indigo_init_array_item(properties[5]->items + 1, "ARRAY_1", "Array 1", INDIGO_ARRAY_DOUBLE);
+	for (int i = 0; i < 24; i++)
+		((float *)array_data)[i] = i / 3.0f;
+	indigo_set_array_item_value(properties[5]->items, array_data, 3, 2, 3, 4);
+}
+
+static void update_properties() {
+	int text_count = properties[0]->count;
+	for (int k = 0; k < text_count; k++) {
+		for (int i = 0; i < text_count; i++)
+			strcpy(properties[0]->items[i].text.value, text_values[(i + k + 1) % text_count]);
+		indigo_update_property(&test_device, properties[0], "%s", text_values[k]);
+	}
+	properties[1]->items[0].number.value = 1e-7;
+	properties[1]->items[1].number.target = -2.5;
+	indigo_update_property(&test_device, properties[1], NULL);
+	properties[2]->items[0].sw.value = true;
+	indigo_update_property(&test_device, properties[2], NULL);
+	properties[3]->state = INDIGO_OK_STATE;
+	properties[3]->items[0].light.value = INDIGO_OK_STATE;
+	indigo_update_property(&test_device, properties[3], NULL);
+	indigo_update_property(&test_device, properties[4], NULL);
+	properties[4]->state = INDIGO_BUSY_STATE;
+	indigo_update_property(&test_device, properties[4], NULL);
+	((float *)array_data)[23] = -1;
+	indigo_update_property(&test_device, properties[5], NULL);
+	indigo_set_array_item_value(properties[5]->items, array_data, 1, 24);
+	indigo_update_property(&test_device, properties[5], "%s", "reshaped");
+	for (int i = 0; i < sizeof(messages) / sizeof(char *); i++)
+		indigo_send_message(&test_device, messages[i]);
+}
+
+int main(int argc, const char * argv[]) {
+	indigo_main_argc = argc;
+	indigo_main_argv = argv;
+	init_properties();
+	indigo_start();
+	indigo_attach_device(&test_device);
+	int request[2];
+	char stream_name[] = "/tmp/indigo_bin_test_XXXXXX";
+	int stream = mkstemp(stream_name);
+	if (stream < 0 || pipe(request) < 0) {
+		indigo_error("can't create test stream");
+		return EXIT_FAILURE;
+	}
+	unlink(stream_name);
+	/* preamble, enableBLOB Also, getProperties for all devices */
+	static const uint8_t requests[] = { INDIGO_BIN_MAGIC, 'I', 'B', INDIGO_BIN_PROTOCOL_VERSION, INDIGO_BIN_ENABLE_BLOB, INDIGO_ENABLE_BLOB_ALSO, INDIGO_BIN_GET_PROPERTIES, 0, 0, 0, 0 };
+	write(request[1], requests, sizeof(requests));
+	close(request[1]);
+	/* adapter closes its handles on detach */
+	indigo_client *device_adapter = indigo_bin_device_adapter(request[0], dup(stream));
+	indigo_attach_client(device_adapter);
+	/* broadcast between attach and preamble echo must not reach the stream */
+	indigo_update_property(&test_device, properties[0], NULL);
+	indigo_attach_client(&recorder_client);
+	indigo_bin_parse(NULL, device_adapter);
+	update_properties();
+	indigo_detach_client(device_adapter);
+	indigo_detach_client(&recorder_client);
+	indigo_detach_device(&test_device);
+	indigo_stop();
+	decode_stream(stream);
+	close(stream);
+	indigo_release_bin_device_adapter(device_adapter);
+	check(replay_count == record_count && message_count == sizeof(messages) / sizeof(char *), &INDIGO_ALL_PROPERTIES, NULL, "message count");
+	indigo_log("%d checks, %d failures", checks, failures);
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
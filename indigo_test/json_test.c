@@ -0,0 +1,93 @@
+// Copyright (c) 2016 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 Build 0 - PoC by Peter Polakovic <peter.polakovic@cloudmakers.eu>
+
+// JSON wire protocol test: messages relayed from chained XML server are serialized by JSON device side adapter
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+
+#include "indigo_bus.h"
+#include "indigo_xml.h"
+#include "indigo_client_xml.h"
+#include "indigo_driver_json.h"
+
+/* empty message is broadcasted as NULL */
+
+static const char *xml_stream =
+	"<message/>\n"
+	"<message message='Say \"hi\" \\ again'/>\n";
+
+static const char *expected_json =
+	"{ \"message\": \"\" }"
+	"{ \"message\": \"Say \\\"hi\\\" \\\\ again\" }";
+
+static int create_stream(const char *data) {
+	char stream_name[] = "/tmp/indigo_json_test_XXXXXX";
+	int stream = mkstemp(stream_name);
+	if (stream < 0)
+		return -1;
+	unlink(stream_name);
+	if (data != NULL) {
+		write(stream, data, strlen(data));
+		lseek(stream, 0, SEEK_SET);
+	}
+	return stream;
+}
+
+int main(int argc, const char * argv[]) {
+	indigo_main_argc = argc;
+	indigo_main_argv = argv;
+	int input = create_stream(xml_stream);
+	int output = create_stream(NULL);
+	if (input < 0 || output < 0) {
+		indigo_error("can't create test stream");
+		return EXIT_FAILURE;
+	}
+	indigo_start();
+	/* adapter closes its handles on detach */
+	indigo_client *device_adapter = indigo_json_device_adapter(open("/dev/null", O_RDONLY), dup(output), false);
+	indigo_attach_client(device_adapter);
+	indigo_device *client_adapter = indigo_xml_client_adapter("JSON Test Server", "", input, open("/dev/null", O_WRONLY));
+	indigo_attach_device(client_adapter);
+	indigo_xml_parse(client_adapter, NULL);
+	indigo_detach_device(client_adapter);
+	indigo_detach_client(device_adapter);
+	indigo_stop();
+	char result[1024];
+	long length = lseek(output, 0, SEEK_END);
+	lseek(output, 0, SEEK_SET);
+	if (length >= sizeof(result) || read(output, result, length) != length) {
+		indigo_error("unexpected output size %ld", length);
+		return EXIT_FAILURE;
+	}
+	result[length] = 0;
+	close(output);
+	indigo_release_json_device_adapter(device_adapter);
+	if (strcmp(result, expected_json)) {
+		indigo_error("unexpected output '%s'", result);
+		return EXIT_FAILURE;
+	}
+	indigo_log("messages serialized correctly");
+	return EXIT_SUCCESS;
+}
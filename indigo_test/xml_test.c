@@ -0,0 +1,281 @@
+// Copyright (c) 2016 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// version history
+// 2.0 Build 0 - PoC by Peter Polakovic <peter.polakovic@cloudmakers.eu>
+
+// XML wire protocol round-trip test: properties are serialized by device side adapter into a file and parsed back by client side adapter
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <assert.h>
+
+#include "indigo_bus.h"
+#include "indigo_xml.h"
+#include "indigo_driver_xml.h"
+#include "indigo_client_xml.h"
+
+#define TEST_DEVICE			"XML Test"
+#define PROPERTY_COUNT	6
+
+static const char *text_values[] = {
+	"short",
+	"0123456789012345678901234567890",
+	"01234567890123456789012345678901",
+	"012345678901234567890123456789012",
+	"/home/observer/images/M31_light_0001_long_name.fits",
+	"escaped <tag attr='value'> & \"quoted\" text which is longer than thirty two characters",
+	""
+};
+
+typedef struct {
+	bool definition;
+	indigo_property *property;
+	char message[INDIGO_VALUE_SIZE];
+} record;
+
+static indigo_property *properties[PROPERTY_COUNT];
+static unsigned char blob_data[10000];
+static double array_data[2][3][4];
+static record records[64];
+static int record_count = 0, replay_count = 0;
+static int checks = 0, failures = 0;
+
+static indigo_result test_enumerate_properties(indigo_device *device, indigo_client *client, indigo_property *property) {
+	for (int i = 0; i < PROPERTY_COUNT; i++)
+		indigo_define_property(device, properties[i], NULL);
+	return INDIGO_OK;
+}
+
+static indigo_device test_device = {
+	TEST_DEVICE, NULL, NULL, INDIGO_OK, INDIGO_VERSION_CURRENT,
+	NULL,
+	test_enumerate_properties,
+	NULL,
+	NULL
+};
+
+/* recorder keeps deep copy of everything broadcasted by test device */
+
+static void record_property(bool definition, indigo_property *property, const char *message) {
+	assert(record_count < sizeof(records) / sizeof(record));
+	record *r = records + record_count++;
+	int size = sizeof(indigo_property) + property->count * sizeof(indigo_item);
+	r->definition = definition;
+	r->property = malloc(size);
+	memcpy(r->property, property, size);
+	strcpy(r->message, message ? message : "");
+	for (int i = 0; i < property->count; i++) {
+		indigo_item *item = r->property->items + i;
+		if (property->type == INDIGO_BLOB_VECTOR && item->blob.value != NULL) {
+			item->blob.value = malloc(item->blob.size);
+			memcpy(item->blob.value, property->items[i].blob.value, item->blob.size);
+		} else if (property->type == INDIGO_ARRAY_VECTOR && item->array.value != NULL) {
+			long size = item->array.count * indigo_array_element_size(item->array.type);
+			item->array.value = malloc(size);
+			memcpy(item->array.value, property->items[i].array.value, size);
+		}
+	}
+}
+
+static indigo_result recorder_define_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
+	record_property(true, property, message);
+	return INDIGO_OK;
+}
+
+static indigo_result recorder_update_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
+	record_property(false, property, message);
+	return INDIGO_OK;
+}
+
+static indigo_client recorder_client = {
+	"XML Test Recorder", NULL, INDIGO_OK, INDIGO_VERSION_CURRENT, INDIGO_ENABLE_BLOB_ALSO,
+	NULL,
+	recorder_define_property,
+	recorder_update_property,
+	NULL,
+	NULL,
+	NULL
+};
+
+/* test client compares everything received from the stream with recorded data */
+
+static void check(bool condition, indigo_property *property, indigo_item *item, const char *what) {
+	checks++;
+	if (!condition) {
+		failures++;
+		indigo_error("%s.%s.%s: %s mismatch", property->device, property->name, item ? item->name : "", what);
+	}
+}
+
+static void compare_property(bool definition, indigo_property *property, const char *message) {
+	if (replay_count >= record_count) {
+		check(false, property, NULL, "unexpected message");
+		return;
+	}
+	record *r = records + replay_count++;
+	indigo_property *original = r->property;
+	check(r->definition == definition, property, NULL, "message type");
+	check(!strcmp(r->message, message ? message : ""), property, NULL, "message");
+	if (strcmp(original->name, property->name) || original->type != property->type || original->count != property->count || original->state != property->state) {
+		check(false, property, NULL, "property");
+		return;
+	}
+	for (int i = 0; i < property->count; i++) {
+		indigo_item *item = property->items + i, *original_item = original->items + i;
+		check(!strcmp(item->name, original_item->name), property, item, "name");
+		if (definition)
+			check(!strcmp(item->label, original_item->label), property, item, "label");
+		switch (property->type) {
+			case INDIGO_TEXT_VECTOR:
+				check(!strcmp(item->text.value, original_item->text.value), property, item, "text");
+				break;
+			case INDIGO_NUMBER_VECTOR:
+				check(item->number.value == original_item->number.value, property, item, "number");
+				break;
+			case INDIGO_SWITCH_VECTOR:
+				check(item->sw.value == original_item->sw.value, property, item, "switch");
+				break;
+			case INDIGO_LIGHT_VECTOR:
+				check(item->light.value == original_item->light.value, property, item, "light");
+				break;
+			case INDIGO_BLOB_VECTOR:
+				if (!definition)
+					check(item->blob.size == original_item->blob.size && item->blob.value != NULL && !memcmp(item->blob.value, original_item->blob.value, item->blob.size), property, item, "BLOB");
+				break;
+			case INDIGO_ARRAY_VECTOR:
+				check(item->array.type == original_item->array.type, property, item, "array type");
+				if (!definition)
+					check(item->array.count == original_item->array.count && item->array.rank == original_item->array.rank && !memcmp(item->array.shape, original_item->array.shape, sizeof(item->array.shape)) && !memcmp(item->array.value, original_item->array.value, item->array.count * indigo_array_element_size(item->array.type)), property, item, "array");
+				break;
+		}
+	}
+}
+
+static indigo_result test_define_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
+	compare_property(true, property, message);
+	return INDIGO_OK;
+}
+
+static indigo_result test_update_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
+	compare_property(false, property, message);
+	return INDIGO_OK;
+}
+
+static indigo_client test_client = {
+	"XML Test Client", NULL, INDIGO_OK, INDIGO_VERSION_CURRENT, INDIGO_ENABLE_BLOB_ALSO,
+	NULL,
+	test_define_property,
+	test_update_property,
+	NULL,
+	NULL,
+	NULL
+};
+
+static void init_properties() {
+	int text_count = sizeof(text_values) / sizeof(char *);
+	properties[0] = indigo_init_text_property(NULL, TEST_DEVICE, "TEXT", "Main", "Text", INDIGO_OK_STATE, INDIGO_RW_PERM, text_count);
+	for (int i = 0; i < text_count; i++) {
+		char name[INDIGO_NAME_SIZE];
+		sprintf(name, "TEXT_%d", i);
+		indigo_init_text_item(properties[0]->items + i, name, name, "%s", text_values[i]);
+	}
+	properties[1] = indigo_init_number_property(NULL, TEST_DEVICE, "NUMBER", "Main", "Number", INDIGO_OK_STATE, INDIGO_RW_PERM, 3);
+	indigo_init_number_item(properties[1]->items, "NUMBER_0", "Number 0", -1e10, 1e10, 0, 0.1);
+	indigo_init_number_item(properties[1]->items + 1, "NUMBER_1", "Number 1", -1e10, 1e10, 0, -1.0 / 3.0);
+	indigo_init_number_item(properties[1]->items + 2, "NUMBER_2", "Number 2", -1e30, 1e30, 0, 6.02214076e23);
+	properties[2] = indigo_init_switch_property(NULL, TEST_DEVICE, "SWITCH", "Main", "Switch", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_ONE_OF_MANY_RULE, 2);
+	indigo_init_switch_item(properties[2]->items, "SWITCH_0", "Switch 0", false);
+	indigo_init_switch_item(properties[2]->items + 1, "SWITCH_1", "Switch <1> & 'one'", true);
+	properties[3] = indigo_init_light_property(NULL, TEST_DEVICE, "LIGHT", "Main", "Light", INDIGO_OK_STATE, 2);
+	indigo_init_light_item(properties[3]->items, "LIGHT_0", "Light 0", INDIGO_BUSY_STATE);
+	indigo_init_light_item(properties[3]->items + 1, "LIGHT_1", "Light \"1\"", INDIGO_ALERT_STATE);
+	properties[4] = indigo_init_blob_property(NULL, TEST_DEVICE, "BLOB", "Main", "BLOB", INDIGO_OK_STATE, 1);
+	indigo_init_blob_item(properties[4]->items, "BLOB_0", "BLOB <0>");
+	for (int i = 0; i < sizeof(blob_data); i++)
+		blob_data[i] = (unsigned char)(i * 7 + (i >> 8));
+	strcpy(properties[4]->items[0].blob.format, ".raw");
+	properties[4]->items[0].blob.value = blob_data;
+	properties[4]->items[0].blob.size = sizeof(blob_data);
+	properties[5] = indigo_init_array_property(NULL, TEST_DEVICE, "ARRAY", "Main", "Array", INDIGO_OK_STATE, 1);
+	indigo_init_array_item(properties[5]->items, "ARRAY_0", "Array 0", INDIGO_ARRAY_DOUBLE);
+	for (int i = 0; i < 24; i++)
+		((double *)array_data)[i] = i / 3.0;
+	indigo_set_array_item_value(properties[5]->items, array_data, 3, 2, 3, 4);
+}
+
+static void update_properties() {
+	int text_count = properties[0]->count;
+	for (int k = 0; k < text_count; k++) {
+		/* rotate values, so every item gets long value in set message */
+		for (int i = 0; i < text_count; i++)
+			strcpy(properties[0]->items[i].text.value, text_values[(i + k + 1) % text_count]);
+		indigo_update_property(&test_device, properties[0], "%s", text_values[5]);
+	}
+	properties[1]->items[0].number.value = 1e-7;
+	indigo_update_property(&test_device, properties[1], NULL);
+	indigo_set_switch(properties[2], properties[2]->items, true);
+	indigo_update_property(&test_device, properties[2], NULL);
+	properties[3]->items[0].light.value = INDIGO_OK_STATE;
+	indigo_update_property(&test_device, properties[3], NULL);
+	indigo_update_property(&test_device, properties[4], NULL);
+	((double *)array_data)[23] = -1;
+	indigo_update_property(&test_device, properties[5], NULL);
+}
+
+int main(int argc, const char * argv[]) {
+	indigo_main_argc = argc;
+	indigo_main_argv = argv;
+	init_properties();
+	indigo_start();
+	indigo_attach_device(&test_device);
+	indigo_attach_client(&recorder_client);
+	int request[2];
+	char stream_name[] = "/tmp/indigo_xml_test_XXXXXX";
+	int stream = mkstemp(stream_name);
+	if (stream < 0 || pipe(request) < 0) {
+		indigo_error("can't create test stream");
+		return EXIT_FAILURE;
+	}
+	unlink(stream_name);
+	const char *get_properties = "<getProperties version='2.0' switch='2.0'/>\n<enableBLOB>Also</enableBLOB>\n";
+	write(request[1], get_properties, strlen(get_properties));
+	close(request[1]);
+	indigo_client *device_adapter = indigo_xml_device_adapter(request[0], stream);
+	indigo_attach_client(device_adapter);
+	indigo_xml_parse(NULL, device_adapter);
+	update_properties();
+	indigo_detach_client(device_adapter);
+	indigo_detach_client(&recorder_client);
+	indigo_detach_device(&test_device);
+	lseek(stream, 0, SEEK_SET);
+	indigo_use_host_suffix = false;
+	indigo_attach_client(&test_client);
+	indigo_device *client_adapter = indigo_xml_client_adapter("XML Test Server", "", stream, open("/dev/null", O_WRONLY));
+	indigo_attach_device(client_adapter);
+	indigo_xml_parse(client_adapter, NULL);
+	indigo_detach_device(client_adapter);
+	indigo_detach_client(&test_client);
+	indigo_stop();
+	check(replay_count == record_count, &INDIGO_ALL_PROPERTIES, NULL, "message count");
+	indigo_log("%d checks, %d failures", checks, failures);
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -215,6 +215,9 @@ void print_property_string(indigo_property *property, const char *message) {
 		case INDIGO_BLOB_VECTOR:
 			strcpy(type_str, "BLOB_VECTOR");
 			break;
+		case INDIGO_ARRAY_VECTOR:
+			strcpy(type_str, "ARRAY_VECTOR");
+			break;
 		}
 
 		char state_str[20] = "";
@@ -281,6 +284,9 @@ void print_property_string(indigo_property *property, const char *message) {
 				printf("%s.%s.%s = <NO BLOB DATA>\n", property->device, property->name, item->name);
 			}
 			break;
+		case INDIGO_ARRAY_VECTOR:
+			printf("%s.%s.%s = <ARRAY %ld x %s>\n", property->device, property->name, item->name, item->array.count, indigo_array_type_text[item->array.type]);
+			break;
 		}
 	}
 	if (print_verbose) printf("\n");
@@ -372,6 +378,9 @@ static indigo_result client_define_property(struct indigo_client *client, struct
 			case INDIGO_BLOB_VECTOR:
 				printf("%s.%s.%s = <BLOB NOT SHOWN>\n", property->device, property->name, item->name);
 				break;
+			case INDIGO_ARRAY_VECTOR:
+				printf("%s.%s.%s = <ARRAY NOT SHOWN>\n", property->device, property->name, item->name);
+				break;
 			}
 
 			//printf("MATCHED:\n");